@@ -7,10 +7,412 @@
 #include <stdexcept>
 #include <concepts>
 #include <type_traits>
+#include <algorithm>
+#include <array>
+#include <span>
+#include <cstdint>
 #include "arrow_proxy.h"
 
-/// @brief Packed array storing integral elements across bit planes.
-template<std::size_t N, std::integral T>
+/**
+ * @brief Kernels converting between plain values and bit planes.
+ *
+ * Eight values by eight planes form an 8x8 bit matrix that fits one
+ * 64-bit word, so a group of eight values is gathered a byte each,
+ * transposed with three masked swaps and scattered as one byte into each
+ * of eight plane words. Planes are exchanged with std::bitset 64 bits at
+ * a time, which costs a handful of word operations per plane instead of
+ * one bit test or set per value and plane.
+ */
+namespace packed_bits {
+
+/// @brief Transpose the 8x8 bit matrix held in a word, byte r being row r.
+constexpr std::uint64_t transpose8(std::uint64_t x) noexcept
+{
+    std::uint64_t t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaull;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccull;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ull;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+/// @brief Number of 64-bit words covering N bits.
+template<std::size_t N>
+inline constexpr std::size_t words = (N + 63) / 64;
+
+/// @brief Bits [64 * w, 64 * w + 64) of a bitset.
+template<std::size_t N>
+std::uint64_t word_of(const std::bitset<N>& bits, std::size_t w)
+{
+    if constexpr (N <= 64) {
+        return bits.to_ullong();
+    } else {
+        static const std::bitset<N> low{~std::uint64_t{0}};
+        return ((bits >> (64 * w)) & low).to_ullong();
+    }
+}
+
+/// @brief Bitset made of words, lowest first.
+template<std::size_t N>
+std::bitset<N> from_words(const std::array<std::uint64_t, words<N>>& ws)
+{
+    std::bitset<N> out{ws[words<N> - 1]};
+    for (std::size_t w = words<N> - 1; w-- > 0;) {
+        out <<= 64;
+        out |= std::bitset<N>{ws[w]};
+    }
+    return out;
+}
+
+/// @brief Fill planes with bits [0, planes.size()) of each value.
+template<std::integral T, std::size_t N>
+void store_planes(const std::array<T, N>& values, std::span<std::bitset<N>> planes)
+{
+    using unsigned_t = std::make_unsigned_t<T>;
+    constexpr std::size_t digits = sizeof(unsigned_t) * CHAR_BIT;
+    std::array<std::array<std::uint64_t, words<N>>, digits> out{};
+    const std::size_t count = planes.size();
+    for (std::size_t g = 0; g * 8 < N; ++g) {
+        for (std::size_t p = 0; p * 8 < count; ++p) {
+            std::uint64_t x = 0;
+            for (std::size_t k = 0; k < 8 && g * 8 + k < N; ++k) {
+                const auto u = static_cast<std::uint64_t>(std::bit_cast<unsigned_t>(values[g * 8 + k]));
+                x |= ((u >> (8 * p)) & 0xffu) << (8 * k);
+            }
+            if (x == 0) continue;
+            x = transpose8(x);
+            for (std::size_t j = 0; j < 8 && p * 8 + j < count; ++j)
+                out[p * 8 + j][g / 8] |= ((x >> (8 * j)) & 0xffu) << (8 * (g % 8));
+        }
+    }
+    for (std::size_t b = 0; b < count; ++b) planes[b] = from_words<N>(out[b]);
+}
+
+/// @brief Values whose low planes.size() bits come from planes, the rest zero.
+template<std::integral T, std::size_t N>
+std::array<T, N> load_planes(std::span<const std::bitset<N>> planes)
+{
+    using unsigned_t = std::make_unsigned_t<T>;
+    constexpr std::size_t digits = sizeof(unsigned_t) * CHAR_BIT;
+    std::array<std::array<std::uint64_t, words<N>>, digits> in{};
+    const std::size_t count = planes.size();
+    for (std::size_t b = 0; b < count; ++b)
+        for (std::size_t w = 0; w < words<N>; ++w) in[b][w] = word_of(planes[b], w);
+    std::array<unsigned_t, N> out{};
+    for (std::size_t g = 0; g * 8 < N; ++g) {
+        for (std::size_t p = 0; p * 8 < count; ++p) {
+            std::uint64_t x = 0;
+            for (std::size_t j = 0; j < 8 && p * 8 + j < count; ++j)
+                x |= ((in[p * 8 + j][g / 8] >> (8 * (g % 8))) & 0xffu) << (8 * j);
+            if (x == 0) continue;
+            x = transpose8(x);
+            for (std::size_t k = 0; k < 8 && g * 8 + k < N; ++k)
+                out[g * 8 + k] |= static_cast<unsigned_t>(((x >> (8 * k)) & 0xffu) << (8 * p));
+        }
+    }
+    return std::bit_cast<std::array<T, N>>(out);
+}
+
+/**
+ * @brief Lanes whose bits match pattern in every plane.
+ *
+ * The AND of the planes set in pattern and the complements of the others;
+ * Plane is std::bitset or an integer or wide bucket mask.
+ */
+template<typename Plane>
+Plane match(std::span<const Plane> planes, std::uint64_t pattern)
+{
+    Plane out = static_cast<Plane>(~Plane{});
+    for (std::size_t b = 0; b < planes.size(); ++b) {
+        if ((pattern >> b) & 1u) out &= planes[b];
+        else out &= static_cast<Plane>(~planes[b]);
+    }
+    return out;
+}
+
+/// @brief Lanes equal to v; planes past the stored ones are zero.
+template<typename Plane, std::integral T>
+Plane equal(std::span<const Plane> planes, T v)
+{
+    using unsigned_t = std::make_unsigned_t<T>;
+    constexpr std::size_t digits = sizeof(unsigned_t) * CHAR_BIT;
+    const auto u = std::bit_cast<unsigned_t>(v);
+    if (planes.size() < digits && (u >> planes.size()) != 0) return Plane{};
+    return match(planes, static_cast<std::uint64_t>(u));
+}
+
+/**
+ * @brief Lanes holding a value less than v.
+ *
+ * Walks the planes from the most significant one, keeping the lanes
+ * still equal to v so far; a lane drops below v at the first plane
+ * where v has a one and the lane a zero. Signed values are compared by
+ * flipping the sign plane, which is stored only if some lane is negative.
+ */
+template<typename Plane, std::integral T>
+Plane less(std::span<const Plane> planes, T v)
+{
+    using unsigned_t = std::make_unsigned_t<T>;
+    constexpr std::size_t digits = sizeof(unsigned_t) * CHAR_BIT;
+    const auto u = std::bit_cast<unsigned_t>(v);
+    const std::size_t count = planes.size();
+    if constexpr (std::is_signed_v<T>) {
+        if (count < digits) {
+            // Every lane is non-negative.
+            if (v <= 0) return Plane{};
+            if ((u >> count) != 0) return static_cast<Plane>(~Plane{});
+        }
+    } else {
+        if (count < digits && (u >> count) != 0) return static_cast<Plane>(~Plane{});
+    }
+    Plane lt{};
+    Plane eq = static_cast<Plane>(~Plane{});
+    for (std::size_t b = count; b-- > 0;) {
+        Plane plane = planes[b];
+        bool bit = (u >> b) & 1u;
+        if (std::is_signed_v<T> && b == digits - 1) {
+            plane = static_cast<Plane>(~plane);
+            bit = !bit;
+        }
+        if (bit) {
+            lt |= eq & static_cast<Plane>(~plane);
+            eq &= plane;
+        } else {
+            eq &= static_cast<Plane>(~plane);
+        }
+    }
+    return lt;
+}
+
+/// @brief Value of lane i.
+template<std::integral T, std::size_t N>
+T lane(std::span<const std::bitset<N>> planes, std::size_t i)
+{
+    using unsigned_t = std::make_unsigned_t<T>;
+    unsigned_t v = 0;
+    for (std::size_t b = 0; b < planes.size(); ++b)
+        if (planes[b][i]) v |= unsigned_t{1} << b;
+    return std::bit_cast<T>(v);
+}
+
+} // namespace packed_bits
+
+/**
+ * @brief Encoding storing the two's complement bits of each value.
+ *
+ * A single negative value makes every lane of the array pay for all
+ * planes of T; see zigzag_encoding and frame_of_reference_encoding.
+ */
+struct plain_encoding {
+    /// @brief Conversion between values and stored bits.
+    template<std::integral T>
+    struct codec {
+        using unsigned_t = std::make_unsigned_t<T>;
+        /// @brief Codec suited to values; plain encoding has no parameters.
+        static codec fit(std::span<const T>) noexcept { return {}; }
+        /// @brief True if v can be encoded without refitting.
+        constexpr bool fits(T) const noexcept { return true; }
+        /// @brief Stored bits of v.
+        constexpr unsigned_t encode(T v) const noexcept { return std::bit_cast<unsigned_t>(v); }
+        /// @brief Value of stored bits u.
+        constexpr T decode(unsigned_t u) const noexcept { return std::bit_cast<T>(u); }
+        /// @brief Lanes holding a value less than v.
+        template<typename Plane>
+        Plane less(std::span<const Plane> planes, T v) const { return packed_bits::less(planes, v); }
+    };
+};
+
+/**
+ * @brief Encoding interleaving signed values as 0, -1, 1, -2, 2, ...
+ *
+ * A value of magnitude m needs about bit_width(m) + 1 planes whatever its
+ * sign, so small signed values such as height deltas stay narrow.
+ */
+struct zigzag_encoding {
+    /// @brief Conversion between values and stored bits.
+    template<std::integral T>
+    struct codec {
+        static_assert(std::is_signed_v<T>, "zigzag_encoding needs a signed value type");
+        using unsigned_t = std::make_unsigned_t<T>;
+        static constexpr int digits = sizeof(T) * CHAR_BIT;
+        /// @brief Codec suited to values; zigzag has no parameters.
+        static codec fit(std::span<const T>) noexcept { return {}; }
+        /// @brief True if v can be encoded without refitting.
+        constexpr bool fits(T) const noexcept { return true; }
+        /// @brief Stored bits of v.
+        constexpr unsigned_t encode(T v) const noexcept {
+            return static_cast<unsigned_t>(std::bit_cast<unsigned_t>(v) << 1)
+                 ^ std::bit_cast<unsigned_t>(static_cast<T>(v >> (digits - 1)));
+        }
+        /// @brief Value of stored bits u.
+        constexpr T decode(unsigned_t u) const noexcept {
+            return std::bit_cast<T>(static_cast<unsigned_t>((u >> 1) ^ static_cast<unsigned_t>(0u - (u & 1u))));
+        }
+        /// @brief Lanes holding a value less than v; negative values are the odd codes.
+        template<typename Plane>
+        Plane less(std::span<const Plane> planes, T v) const {
+            const Plane odd = planes.empty() ? Plane{} : planes[0];
+            const unsigned_t c = encode(v);
+            if (v > 0) return odd | packed_bits::less(planes, c);
+            return odd & ~(packed_bits::less(planes, c) | packed_bits::equal(planes, c));
+        }
+    };
+};
+
+/**
+ * @brief Encoding storing offsets from the smallest value.
+ *
+ * Clustered values such as absolute heights or densities near a common
+ * level need only as many planes as their spread. Writing a value below
+ * the base refits the whole array.
+ */
+struct frame_of_reference_encoding {
+    /// @brief Conversion between values and stored bits.
+    template<std::integral T>
+    struct codec {
+        using unsigned_t = std::make_unsigned_t<T>;
+        /// @brief Smallest representable value.
+        T base{};
+        /// @brief Codec based at the smallest of values.
+        static codec fit(std::span<const T> values) noexcept {
+            return {values.empty() ? T{} : *std::min_element(values.begin(), values.end())};
+        }
+        /// @brief True if v is not below the base.
+        constexpr bool fits(T v) const noexcept { return v >= base; }
+        /// @brief Stored bits of v.
+        constexpr unsigned_t encode(T v) const noexcept {
+            return static_cast<unsigned_t>(std::bit_cast<unsigned_t>(v) - std::bit_cast<unsigned_t>(base));
+        }
+        /// @brief Value of stored bits u.
+        constexpr T decode(unsigned_t u) const noexcept {
+            return std::bit_cast<T>(static_cast<unsigned_t>(u + std::bit_cast<unsigned_t>(base)));
+        }
+        /// @brief Lanes holding a value less than v; offsets keep the order of values.
+        template<typename Plane>
+        Plane less(std::span<const Plane> planes, T v) const {
+            if (v <= base) return Plane{};
+            return packed_bits::less(planes, encode(v));
+        }
+    };
+};
+
+namespace packed_bits {
+
+/// @brief Plane buffer of at most MaxPlanes planes stored inline.
+template<std::size_t N, std::size_t MaxPlanes>
+class fixed_plane_buffer {
+public:
+    /// @brief Number of planes in use.
+    std::size_t size() const noexcept { return size_; }
+    /// @brief True if no plane is in use.
+    bool empty() const noexcept { return size_ == 0; }
+    /// @brief First plane.
+    std::bitset<N>* data() noexcept { return planes_.data(); }
+    /// @brief First plane (const).
+    const std::bitset<N>* data() const noexcept { return planes_.data(); }
+    /// @brief Plane b.
+    std::bitset<N>& operator[](std::size_t b) noexcept { return planes_[b]; }
+    /// @brief Plane b (const).
+    const std::bitset<N>& operator[](std::size_t b) const noexcept { return planes_[b]; }
+    /// @brief Highest plane in use.
+    std::bitset<N>& back() noexcept { return planes_[size_ - 1]; }
+    /// @brief Drop the highest plane.
+    void pop_back() noexcept { --size_; }
+    /// @brief Use n planes, new ones cleared; throws std::length_error past MaxPlanes.
+    void resize(std::size_t n) {
+        if (n > MaxPlanes) throw std::length_error("array_packed: value needs more planes than the fixed capacity");
+        for (std::size_t b = size_; b < n; ++b) planes_[b].reset();
+        size_ = n;
+    }
+
+private:
+    /// @brief Plane storage; entries past size_ are unspecified.
+    std::array<std::bitset<N>, MaxPlanes> planes_{};
+    /// @brief Number of planes in use.
+    std::size_t size_{0};
+};
+
+/// @brief Plane buffer keeping up to InlinePlanes planes inline and spilling wider values to the heap.
+template<std::size_t N, std::size_t InlinePlanes>
+class small_plane_buffer {
+public:
+    /// @brief Number of planes in use.
+    std::size_t size() const noexcept { return size_; }
+    /// @brief True if no plane is in use.
+    bool empty() const noexcept { return size_ == 0; }
+    /// @brief First plane.
+    std::bitset<N>* data() noexcept { return spilled() ? heap_.data() : inline_.data(); }
+    /// @brief First plane (const).
+    const std::bitset<N>* data() const noexcept { return spilled() ? heap_.data() : inline_.data(); }
+    /// @brief Plane b.
+    std::bitset<N>& operator[](std::size_t b) noexcept { return data()[b]; }
+    /// @brief Plane b (const).
+    const std::bitset<N>& operator[](std::size_t b) const noexcept { return data()[b]; }
+    /// @brief Highest plane in use.
+    std::bitset<N>& back() noexcept { return data()[size_ - 1]; }
+    /// @brief Drop the highest plane.
+    void pop_back() { resize(size_ - 1); }
+    /// @brief Use n planes, new ones cleared, moving between inline and heap storage as needed.
+    void resize(std::size_t n) {
+        if (n <= InlinePlanes) {
+            if (spilled()) {
+                std::copy_n(heap_.begin(), n, inline_.begin());
+                heap_ = {};
+            } else {
+                for (std::size_t b = size_; b < n; ++b) inline_[b].reset();
+            }
+        } else {
+            if (!spilled()) heap_.assign(inline_.begin(), inline_.begin() + static_cast<std::ptrdiff_t>(size_));
+            heap_.resize(n);
+        }
+        size_ = n;
+    }
+
+private:
+    /// @brief True if the planes live on the heap.
+    bool spilled() const noexcept { return size_ > InlinePlanes; }
+
+    /// @brief Inline planes; entries past size_ are unspecified.
+    std::array<std::bitset<N>, InlinePlanes> inline_{};
+    /// @brief All planes once more than InlinePlanes are in use.
+    std::vector<std::bitset<N>> heap_{};
+    /// @brief Number of planes in use.
+    std::size_t size_{0};
+};
+
+} // namespace packed_bits
+
+/// @brief Plane storage in a std::vector: one heap allocation per non-zero array.
+struct heap_planes {
+    template<std::size_t N, std::integral T>
+    using buffer = std::vector<std::bitset<N>>;
+};
+
+/// @brief Inline plane storage for at most MaxPlanes planes, 0 meaning all planes of T.
+template<std::size_t MaxPlanes = 0>
+struct fixed_planes {
+    template<std::size_t N, std::integral T>
+    using buffer = packed_bits::fixed_plane_buffer<N, MaxPlanes ? MaxPlanes : sizeof(T) * CHAR_BIT>;
+};
+
+/// @brief Inline storage for InlinePlanes planes, spilling wider values to the heap.
+template<std::size_t InlinePlanes = 4>
+struct small_planes {
+    template<std::size_t N, std::integral T>
+    using buffer = packed_bits::small_plane_buffer<N, InlinePlanes>;
+};
+
+/**
+ * @brief Packed array storing integral elements across bit planes.
+ *
+ * Encoding maps values to the stored bits: plain_encoding (the default),
+ * zigzag_encoding or frame_of_reference_encoding. The array keeps only as
+ * many planes as its widest stored value needs. Storage holds the planes:
+ * heap_planes (the default), fixed_planes for heap-free arrays of bounded
+ * width or small_planes for inline narrow values and heap-spilled wide ones.
+ */
+template<std::size_t N, std::integral T, typename Encoding = plain_encoding, typename Storage = heap_planes>
 class array_packed {
 public:
     /// @brief Value type stored in the container.
@@ -164,30 +566,81 @@ public:
     /// @brief Number of elements stored.
     static constexpr size_type size() noexcept { return N; }
 
+    /// @brief All values, read with word-level transposes of the planes.
+    std::array<T, N> load_all() const {
+        if constexpr (std::same_as<Encoding, plain_encoding>) {
+            return packed_bits::load_planes<T, N>(planes_view());
+        } else {
+            const auto raw = packed_bits::load_planes<unsigned_t, N>(planes_view());
+            std::array<T, N> out;
+            for (size_type i = 0; i < N; ++i) out[i] = codec_.decode(raw[i]);
+            return out;
+        }
+    }
+
+    /// @brief Overwrite all values, refitting the encoding and keeping only the planes needed.
+    void store_all(const std::array<T, N>& values) {
+        codec_ = codec_type::fit(values);
+        std::array<unsigned_t, N> raw;
+        unsigned_t all = 0;
+        for (size_type i = 0; i < N; ++i) {
+            raw[i] = codec_.encode(values[i]);
+            all |= raw[i];
+        }
+        bits_.resize(static_cast<size_type>(std::bit_width(all)));
+        packed_bits::store_planes<unsigned_t, N>(raw, {bits_.data(), bits_.size()});
+    }
+
+    /// @brief Number of bit planes in use.
+    size_type planes() const noexcept { return bits_.size(); }
+
+    /// @brief Lanes equal to v, found with one AND per plane.
+    std::bitset<N> find_equal(T v) const {
+        if (!codec_.fits(v)) return {};
+        return packed_bits::equal<std::bitset<N>>(planes_view(), codec_.encode(v));
+    }
+    /// @brief Number of lanes equal to v.
+    size_type count_equal(T v) const { return find_equal(v).count(); }
+    /// @brief Lanes holding a value less than v.
+    std::bitset<N> less_than(T v) const { return codec_.template less<std::bitset<N>>(planes_view(), v); }
+
 private:
+    using unsigned_t = std::make_unsigned_t<T>;
+    using codec_type = typename Encoding::template codec<T>;
+
+    /// @brief Bit planes as a span.
+    std::span<const std::bitset<N>> planes_view() const noexcept { return {bits_.data(), bits_.size()}; }
+
     /// @brief Get value at index.
     T get(size_type idx) const {
-        using unsigned_t = std::make_unsigned_t<T>;
         unsigned_t v = 0;
         for (size_type b = 0; b < bits_.size(); ++b) {
-            if (bits_[b].test(idx)) v |= 1u << b;
+            if (bits_[b].test(idx)) v |= unsigned_t{1} << b;
         }
-        return std::bit_cast<T>(v);
+        return codec_.decode(v);
     }
 
-    /// @brief Set value at index.
+    /// @brief Set value at index, refitting if the encoding cannot hold it and dropping emptied top planes.
     void set(size_type idx, T value) {
-        using unsigned_t = std::make_unsigned_t<T>;
-        unsigned_t u = std::bit_cast<unsigned_t>(value);
+        if (!codec_.fits(value)) {
+            auto values = load_all();
+            values[idx] = value;
+            store_all(values);
+            return;
+        }
+        unsigned_t u = codec_.encode(value);
         size_type needed = u ? std::bit_width(u) : 0u;
         if (needed > bits_.size()) bits_.resize(needed);
         for (size_type b = 0; b < bits_.size(); ++b) {
             bool bit = (u >> b) & 1u;
             bits_[b].set(idx, bit);
         }
+        while (!bits_.empty() && bits_.back().none()) bits_.pop_back();
     }
 
     /// @brief Bit planes storing packed element data.
-    std::vector<std::bitset<N>> bits_{};
+    typename Storage::template buffer<N, T> bits_{};
+    /// @brief Encoding parameters, empty unless the encoding has any.
+    [[no_unique_address]] codec_type codec_{};
 };
 
@@ -2,15 +2,16 @@
 
 #include "doctest.h"
 #include <chrono>
-#include <string_view>
+#include <string>
+#include <utility>
 
 namespace bench {
 
 /// @brief RAII timer used for simple benchmarks.
 class BenchmarkGuard {
 public:
-    /// @brief Begin timing with a label.
-    BenchmarkGuard(std::string_view name,
+    /// @brief Begin timing with a label; the guard keeps its own copy.
+    BenchmarkGuard(std::string name,
                    const char* file,
                    int line);
 
@@ -24,17 +25,17 @@ public:
     void stop() { active_ = false; }
 
 private:
-    std::string_view name_{}; ///< Benchmark label.
+    std::string name_{};      ///< Benchmark label.
     const char* file_{};      ///< Source file location.
     int line_{};              ///< Source line location.
     std::chrono::steady_clock::time_point start_{}; ///< Start point of timing.
     bool active_{true};       ///< Loop state flag.
 };
 
-inline BenchmarkGuard::BenchmarkGuard(std::string_view name,
+inline BenchmarkGuard::BenchmarkGuard(std::string name,
                                       const char* file,
                                       int line)
-    : name_{name}, file_{file}, line_{line}, start_{std::chrono::steady_clock::now()} {}
+    : name_{std::move(name)}, file_{file}, line_{line}, start_{std::chrono::steady_clock::now()} {}
 
 inline BenchmarkGuard::~BenchmarkGuard() {
     auto end = std::chrono::steady_clock::now();
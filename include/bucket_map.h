@@ -3,19 +3,54 @@
 #include <limits>
 #include <type_traits>
 #include <vector>
-#include <map>
 #include <utility>
 #include <bit>
+#include <array>
+#include <bitset>
+#include <algorithm>
+#include <ranges>
+#include <span>
+#include <unordered_map>
+#include <functional>
 #include "arrow_proxy.h"
 #include "flat_vector_array_packed.h"
 #include "set_views.h"
-
-/// @brief Map storing values in deduplicated buckets.
-template<typename Key, typename T, typename Bucket = std::uint64_t>
+#include "wide_mask.h"
+
+/// @brief Deduplication policy sharing a stored value among the keys of one bucket.
+struct bucket_dedup {};
+/// @brief Deduplication policy sharing a stored value among all keys through a hash index.
+struct map_dedup {};
+
+/// @brief Types std::hash can hash.
+template<typename T>
+concept hashable = requires(const T& v) { { std::hash<T>{}(v) } -> std::convertible_to<std::size_t>; };
+
+/// @brief map_dedup for hashable values, bucket_dedup otherwise.
+template<typename T>
+using default_dedup = std::conditional_t<hashable<T>, map_dedup, bucket_dedup>;
+
+/**
+ * @brief Map storing values in deduplicated buckets.
+ *
+ * Keys index packed buckets of value indices. With bucket_dedup equal
+ * values are stored once per bucket and found by scanning the bucket;
+ * with map_dedup they are stored once per map and found through a hash
+ * index from value hash to value index.
+ */
+template<typename Key, typename T, typename Bucket = std::uint64_t, typename Dedup = default_dedup<T>>
 class bucket_map {
-    static_assert(std::is_unsigned_v<Bucket>, "Bucket must be unsigned integral");
-    static constexpr std::size_t bits_ = std::numeric_limits<Bucket>::digits;
+    static_assert(bucket_mask<Bucket>, "Bucket must be unsigned integral or a wide_mask");
+    static_assert(std::same_as<Dedup, bucket_dedup> || std::same_as<Dedup, map_dedup>,
+                  "Dedup must be bucket_dedup or map_dedup");
+    static_assert(std::same_as<Dedup, bucket_dedup> || hashable<T>, "map_dedup needs std::hash<T>");
+    static constexpr std::size_t bits_ = mask_traits<Bucket>::bits;
+    static constexpr bool map_wide_ = std::same_as<Dedup, map_dedup>;
     using bucket_array = array_packed<bits_, int>;
+    /// @brief Whether iterators keep a decoded copy of their bucket; wide buckets are read in place.
+    static constexpr bool cache_bucket_ = !is_wide_mask_v<Bucket>;
+    /// @brief Stand-in for an iterator's bucket copy when it is not kept.
+    struct no_cache {};
 public:
     /// @brief Key type used for lookup.
     using key_type    = Key;
@@ -23,6 +58,8 @@ public:
     using mapped_type = T;
     /// @brief Size type of the container.
     using size_type   = std::size_t;
+    /// @brief Deduplication policy.
+    using dedup_policy = Dedup;
 
     /// @brief Node referencing a deduplicated value.
     struct node {
@@ -32,10 +69,9 @@ public:
         /// @brief Keys referencing the value.
         occupied_set occupied() const {
             occupied_set out;
-            for (size_type bit = 0; bit < bits_; ++bit) {
-                if (mask_ & (Bucket{1} << bit))
-                    out.push_back(static_cast<key_type>(bucket_index_ * bits_ + bit));
-            }
+            for_each_set_bit(mask_, [&](size_type bit) {
+                out.push_back(static_cast<key_type>(bucket_index_ * bits_ + bit));
+            });
             return out;
         }
 
@@ -76,8 +112,16 @@ public:
         key_type    key_{}; ///< @brief Referenced key.
     };
 
-    /// @brief Forward iterator over constant elements.
-class const_iterator {
+    /**
+     * @brief Forward iterator over constant elements.
+     *
+     * Holds the current bucket decoded and a mask of its occupied keys at or
+     * after the current one, so stepping is a countr_zero and each bucket's
+     * planes are read once. For wide buckets the decoded copy would be
+     * kilobytes, so the value index is read from the planes on dereference
+     * instead. Empty buckets are skipped on their plane count alone.
+     */
+    class const_iterator {
     public:
         using iterator_category = std::forward_iterator_tag;
         using iterator_concept  = std::forward_iterator_tag;
@@ -89,29 +133,67 @@ class const_iterator {
         /// @brief Default constructed iterator.
         const_iterator() = default;
         /// @brief Construct from map and starting key.
-        const_iterator(const bucket_map* m, size_type k) : map_(m), key_(k) { advance(); }
+        const_iterator(const bucket_map* m, size_type k) : map_(m), key_(k) {
+            load(k / bits_, k % bits_);
+            settle();
+        }
 
         /// @brief Dereference to key/value pair.
-        reference operator*() const { return {key_type(key_), map_->values_[map_->value_index_at(key_)]}; }
+        reference operator*() const {
+            int vi;
+            if constexpr (cache_bucket_) vi = slots_[key_ % bits_];
+            else vi = packed_bits::lane<int>(map_->buckets_.bit_planes(bucket_), key_ % bits_);
+            return {key_type(key_), map_->values_[vi]};
+        }
         /// @brief Arrow operator for structured bindings.
         pointer operator->() const { return pointer{**this}; }
         /// @brief Pre-increment iterator.
-        const_iterator& operator++() { ++key_; advance(); return *this; }
+        const_iterator& operator++() { mask_ = mask_clear_lowest(mask_); settle(); return *this; }
         /// @brief Post-increment iterator.
         const_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+        /// @brief Move to the first used key not below k; never moves backwards.
+        const_iterator& seek(const key_type& k) {
+            const size_type target = std::min(static_cast<size_type>(k), map_->capacity());
+            if (target <= key_) return *this;
+            if (target / bits_ == bucket_) mask_ &= ~Bucket{0} << (target % bits_);
+            else load(target / bits_, target % bits_);
+            settle();
+            return *this;
+        }
         /// @brief Equality comparison.
         bool operator==(const const_iterator& o) const { return key_ == o.key_; }
         /// @brief Inequality comparison.
         bool operator!=(const const_iterator& o) const { return key_ != o.key_; }
     private:
-        /// @brief Skip to next used key.
-        void advance() {
-            while (key_ < map_->capacity() && map_->value_index_at(key_) == 0) ++key_;
+        /// @brief Make bucket b current, keeping occupied keys from bit first on.
+        void load(size_type b, size_type first) {
+            bucket_ = b;
+            mask_ = 0;
+            if (b >= map_->buckets_.size() || map_->buckets_.planes(b) == 0) return;
+            if constexpr (cache_bucket_) slots_ = map_->buckets_.unpack(b);
+            mask_ = map_->occupancy(b) & (~Bucket{0} << first);
+        }
+        /// @brief Move to the lowest remaining key, loading later buckets as needed.
+        void settle() {
+            const auto& buckets = map_->buckets_;
+            while (!mask_) {
+                size_type next = bucket_ + 1;
+                while (next < buckets.size() && buckets.planes(next) == 0) ++next;
+                if (next >= buckets.size()) { bucket_ = next; key_ = map_->capacity(); return; }
+                load(next, 0);
+            }
+            key_ = bucket_ * bits_ + static_cast<size_type>(mask_countr_zero(mask_));
         }
         /// @brief Parent container pointer.
         const bucket_map* map_{};
         /// @brief Current key index.
         size_type key_{};
+        /// @brief Index of the current bucket.
+        size_type bucket_{};
+        /// @brief Occupied keys of the current bucket not yet visited, current one included.
+        Bucket mask_{};
+        /// @brief Value indices of the current bucket, kept for integer buckets only.
+        [[no_unique_address]] std::conditional_t<cache_bucket_, std::array<int, bits_>, no_cache> slots_{};
     };
 
     /// @brief Mutable iterator aliasing const_iterator.
@@ -120,7 +202,17 @@ class const_iterator {
     /// @brief Lazy view providing nodes per bucket.
     class nodes_view {
     public:
-        /// @brief Iterator over lazily computed nodes.
+        /**
+         * @brief Iterator over lazily computed nodes.
+         *
+         * Works on the bit planes of a bucket directly: the keys holding the
+         * value of the lowest unvisited key are the AND of the planes set in
+         * that value and the complements of the others, so each node costs
+         * one pass over the planes and nothing is decoded or allocated.
+         * Nodes of a bucket come in order of their lowest key. The planes of
+         * integer buckets are copied into the iterator; those of wide buckets
+         * are read from the map, as for the element iterator.
+         */
         class const_iterator {
         public:
             using iterator_category = std::forward_iterator_tag;
@@ -138,19 +230,20 @@ class const_iterator {
 
             /// @brief Dereference to bucket/node pair.
             reference operator*() const {
-                auto [vi, mask] = masks_[index_];
                 node n{};
                 n.bucket_index_ = bucket_;
-                n.mask_ = mask;
-                n.value_ptr_ = &map_->values_[vi];
+                n.mask_ = mask_;
+                n.value_ptr_ = &map_->values_[value_];
                 return {bucket_, n};
             }
             /// @brief Arrow operator for structured bindings.
             pointer operator->() const { return pointer{**this}; }
             /// @brief Pre-increment iterator.
             const_iterator& operator++() {
-                ++index_;
-                if (index_ >= masks_.size()) {
+                remaining_ &= ~mask_;
+                if (remaining_) {
+                    select();
+                } else {
                     ++bucket_;
                     load();
                 }
@@ -160,26 +253,45 @@ class const_iterator {
             const_iterator operator++(int) { auto t = *this; ++(*this); return t; }
             /// @brief Equality comparison.
             bool operator==(const const_iterator& o) const {
-                return bucket_ == o.bucket_ && index_ == o.index_;
+                return bucket_ == o.bucket_ && remaining_ == o.remaining_;
             }
             /// @brief Inequality comparison.
             bool operator!=(const const_iterator& o) const { return !(*this == o); }
 
         private:
-            /// @brief Load data for current bucket.
+            /// @brief Move to the first non-empty bucket from bucket_ on, copying its planes if kept.
             void load() {
-                masks_.clear();
-                index_ = 0;
-                while (bucket_ < map_->buckets_.size()) {
-                    std::map<int, Bucket> tmp;
-                    auto arr = map_->buckets_[bucket_];
-                    for (size_type bit = 0; bit < bits_; ++bit) {
-                        int vi = arr[bit];
-                        if (vi != 0) tmp[vi] |= Bucket{1} << bit;
+                remaining_ = 0;
+                for (; bucket_ < map_->buckets_.size(); ++bucket_) {
+                    if constexpr (cache_bucket_) {
+                        const auto planes = map_->buckets_.bit_planes(bucket_);
+                        plane_count_ = planes.size();
+                        for (size_type b = 0; b < plane_count_; ++b) {
+                            planes_[b] = mask_from_bitset<Bucket>(planes[b]);
+                            remaining_ |= planes_[b];
+                        }
+                    } else {
+                        remaining_ = map_->occupancy(bucket_);
                     }
-                    for (auto [vi, mask] : tmp) masks_.push_back({vi, mask});
-                    if (!masks_.empty()) break;
-                    ++bucket_;
+                    if (remaining_) break;
+                }
+                if (remaining_) select();
+            }
+            /// @brief Make the value of the lowest remaining key the current node.
+            void select() {
+                const size_type bit = static_cast<size_type>(mask_countr_zero(remaining_));
+                if constexpr (cache_bucket_) {
+                    int value = 0;
+                    for (size_type b = 0; b < plane_count_; ++b)
+                        if (mask_test(planes_[b], bit)) value |= 1 << b;
+                    value_ = value;
+                    mask_ = packed_bits::match<Bucket>({planes_.data(), plane_count_},
+                                                       static_cast<std::uint64_t>(value)) & remaining_;
+                } else {
+                    const auto planes = map_->buckets_.bit_planes(bucket_);
+                    value_ = packed_bits::lane<int>(planes, bit);
+                    mask_ = mask_from_bitset<Bucket>(packed_bits::match(planes, static_cast<std::uint64_t>(value_)))
+                          & remaining_;
                 }
             }
 
@@ -187,10 +299,17 @@ class const_iterator {
             const bucket_map* map_{};
             /// @brief Current bucket index.
             size_type bucket_{};
-            /// @brief Masks for the current bucket.
-            std::vector<std::pair<int, Bucket>> masks_{};
-            /// @brief Index into the current masks.
-            size_type index_{0};
+            /// @brief Bit planes of the current bucket, kept for integer buckets only.
+            [[no_unique_address]] std::conditional_t<cache_bucket_,
+                std::array<Bucket, std::numeric_limits<int>::digits>, no_cache> planes_{};
+            /// @brief Number of valid entries in planes_.
+            size_type plane_count_{0};
+            /// @brief Occupied keys of the current bucket not yet covered by a node.
+            Bucket remaining_{};
+            /// @brief Keys of the current node.
+            Bucket mask_{};
+            /// @brief Value index of the current node.
+            int value_{0};
         };
 
         /// @brief Begin iterator over nodes.
@@ -205,8 +324,8 @@ class const_iterator {
         const bucket_map* map_{};
     };
 
-    /// @brief Default constructed empty map.
-    bucket_map() { values_.push_back(T{}); }
+    /// @brief Default constructed empty map; allocates nothing until the first insert.
+    bucket_map() noexcept = default;
 
     /// @brief Construct map from input range.
     template<std::ranges::input_range R>
@@ -215,13 +334,34 @@ class const_iterator {
         insert_range(std::forward<R>(range));
     }
 
-    /// @brief Construct map by copying another map.
-    bucket_map(const bucket_map& other) : bucket_map() { insert_range(other); }
+    /// @brief Copy another map; buckets and values are copied wholesale, plane by plane.
+    bucket_map(const bucket_map& other) = default;
+    /// @brief Copy-assign another map wholesale.
+    bucket_map& operator=(const bucket_map& other) = default;
+
+    /// @brief Take over another map's storage, leaving it empty.
+    bucket_map(bucket_map&& other) noexcept
+        : buckets_(std::move(other.buckets_)), values_(std::move(other.values_)),
+          index_(std::move(other.index_)), size_(std::exchange(other.size_, 0)) {
+        other.clear();
+    }
+    /// @brief Take over another map's storage, leaving it empty.
+    bucket_map& operator=(bucket_map&& other) noexcept {
+        bucket_map taken(std::move(other));
+        swap(taken);
+        return *this;
+    }
 
-    /// @brief Construct map by moving another map.
-    bucket_map(bucket_map&& other) noexcept : bucket_map() {
-        insert_range(std::move(other));
+    /// @brief Exchange contents with another map.
+    void swap(bucket_map& other) noexcept {
+        using std::swap;
+        swap(buckets_, other.buckets_);
+        swap(values_, other.values_);
+        swap(index_, other.index_);
+        swap(size_, other.size_);
     }
+    /// @brief Exchange contents of two maps.
+    friend void swap(bucket_map& a, bucket_map& b) noexcept { a.swap(b); }
 
     /// @brief True if container has no elements.
     bool empty() const noexcept { return size_ == 0; }
@@ -229,11 +369,27 @@ class const_iterator {
     /// @brief Number of stored elements.
     size_type size() const noexcept { return size_; }
 
+    /// @brief Number of values held in value storage, each shared value counted once.
+    size_type stored_values() const noexcept { return values_.empty() ? 0 : values_.size() - 1; }
+
+    /**
+     * @brief Release stored values no key refers to and renumber the rest.
+     *
+     * Overwritten and erased keys leave their values behind; this pass
+     * keeps the values still referenced, in order of first use, rewrites
+     * every bucket with the new indices and rebuilds the hash index.
+     * Buckets are re-packed with only as many planes as their largest
+     * index needs and trailing empty buckets are dropped. Invalidates
+     * iterators.
+     * @return Number of values released.
+     */
+    size_type compact();
+
     /// @brief Remove all elements.
     void clear() noexcept {
         buckets_.resize(0);
         values_.clear();
-        values_.push_back(T{});
+        if constexpr (map_wide_) index_.clear();
         size_ = 0;
     }
 
@@ -262,6 +418,11 @@ class const_iterator {
         return const_iterator(this, static_cast<size_type>(key));
     }
 
+    /// @brief Const iterator to the first used key not below key.
+    const_iterator lower_bound(const key_type& key) const {
+        return const_iterator(this, std::min(static_cast<size_type>(key), capacity()));
+    }
+
     /// @brief Insert or assign a value at key.
     void insert_or_assign(const key_type& key, const T& val) {
         insert_or_assign_impl(key, val);
@@ -281,13 +442,56 @@ class const_iterator {
         }
     }
 
+    /**
+     * @brief Insert or assign key/value pairs given in ascending key order.
+     *
+     * Each bucket touched by the run is decoded into a local index array
+     * once, updated in registers and written back once, instead of going
+     * through the packed planes for every key. Out of order keys are still
+     * stored correctly, only with more bucket round trips.
+     */
+    template<std::ranges::input_range R>
+    void assign_sorted(R&& range) {
+        std::array<int, bits_> slots{};
+        std::array<bool, bits_> dirty{};
+        size_type current = npos_bucket;
+        auto flush = [&] {
+            if (current == npos_bucket) return;
+            if (current >= buckets_.size()) buckets_.resize(current + 1);
+            auto arr = buckets_[current];
+            for (size_type bit = 0; bit < bits_; ++bit)
+                if (dirty[bit]) arr[bit] = slots[bit];
+        };
+        for (auto&& elem : range) {
+            const auto key = static_cast<size_type>(std::get<0>(elem));
+            const size_type idx = key / bits_;
+            if (idx != current) {
+                flush();
+                current = idx;
+                dirty.fill(false);
+                if (idx < buckets_.size()) {
+                    auto arr = buckets_[idx];
+                    for (size_type bit = 0; bit < bits_; ++bit) slots[bit] = arr[bit];
+                } else {
+                    slots.fill(0);
+                }
+            }
+            // get<1> of the forwarded element only moves out of rvalue elements.
+            const int val_idx = intern(std::get<1>(std::forward<decltype(elem)>(elem)),
+                                       [&](const T& ref) { return find_in(slots, ref); });
+            const size_type bit = key % bits_;
+            if (slots[bit] == 0) ++size_;
+            slots[bit] = val_idx;
+            dirty[bit] = true;
+        }
+        flush();
+    }
+
     /// @brief Insert all entries from another map.
     void insert_range(const bucket_map& other) {
         if (other.empty()) return;
         if (empty()) {
-            buckets_ = other.buckets_;
-            values_  = other.values_;
-            size_    = other.size_;
+            *this = other;
             return;
         }
         for (size_type b = 0; b < other.buckets_.size(); ++b) {
@@ -304,10 +508,7 @@ class const_iterator {
     void insert_range(bucket_map&& other) {
         if (other.empty()) return;
         if (empty()) {
-            buckets_ = std::move(other.buckets_);
-            values_  = std::move(other.values_);
-            size_    = other.size_;
-            other.clear();
+            *this = std::move(other);
             return;
         }
         std::vector<bool> moved(other.values_.size(), false);
@@ -379,8 +580,25 @@ class const_iterator {
     /// @brief Exclusive adaptor for piping.
     static auto exclusive(const bucket_map& rhs);
 
-    /// @brief Bit mask of occupied entries in a bucket array.
-    static Bucket mask_of(const bucket_array& arr);
+    /**
+     * @brief Eager set operation combining whole buckets at once.
+     *
+     * Occupancy masks of matching buckets are combined with AND, OR and
+     * AND-NOT, and only the surviving slots are decoded and copied. On
+     * shared keys the lhs value wins, as in the lazy views.
+     */
+    template<set_op Op>
+    static bucket_map combine(const bucket_map& lhs, const bucket_map& rhs);
+
+    /**
+     * @brief In-place set operation with rhs, touching only rhs buckets.
+     *
+     * Merge and exclusive decode and rewrite only buckets where rhs adds
+     * keys; subtract only clears bits; overlap clears bits in every
+     * bucket of this map. On shared keys this map's value is kept.
+     */
+    template<set_op Op>
+    void combine_with(const bucket_map& rhs);
 
 private:
     /// @brief Implementation of insert_or_assign with perfect forwarding.
@@ -390,19 +608,72 @@ private:
         auto bit = static_cast<size_type>(key) % bits_;
         if (idx >= buckets_.size()) buckets_.resize(idx + 1);
         auto arr = buckets_[idx];
+        const int val_idx = intern(std::forward<U>(val),
+                                   [&](const T& ref) { return find_in(idx, ref); });
+        if (arr[bit] == 0) ++size_;
+        arr[bit] = val_idx;
+    }
+
+    /**
+     * @brief Index of a value equal to ref stored in bucket idx, or 0.
+     *
+     * Compares each distinct value of the bucket once: the keys sharing a
+     * visited index are dropped with a bit-sliced find_equal on its planes.
+     */
+    int find_in(size_type idx, const T& ref) const {
+        if (idx >= buckets_.size() || buckets_.planes(idx) == 0) return 0;
+        const auto planes = buckets_.bit_planes(idx);
+        std::bitset<bits_> occupied;
+        for (const auto& plane : planes) occupied |= plane;
+        Bucket remaining = mask_from_bitset<Bucket>(occupied);
+        while (remaining) {
+            const int vi = packed_bits::lane<int>(planes, static_cast<size_type>(mask_countr_zero(remaining)));
+            if (values_[vi] == ref) return vi;
+            remaining &= ~mask_from_bitset<Bucket>(packed_bits::equal(planes, vi));
+        }
+        return 0;
+    }
 
+    /// @brief Index of a value equal to ref among the slots of a bucket, or 0.
+    int find_in(const std::array<int, bits_>& slots, const T& ref) const {
+        for (int vi : slots)
+            if (vi != 0 && values_[vi] == ref) return vi;
+        return 0;
+    }
+
+    /**
+     * @brief Index of a stored value equal to val, storing val if there is none.
+     *
+     * scan(val) searches the bucket the value goes to and returns 0 on a
+     * miss. map_dedup asks the hash index first and scans only when the
+     * indexed value merely shares val's hash; such values are stored
+     * unindexed, so one bucket still never holds two equal values.
+     */
+    template<typename U, typename Scan>
+    int intern(U&& val, Scan&& scan) {
         const T& ref = val;
-        int val_idx = 0;
-        for (size_type i = 0; i < bits_; ++i) {
-            int vi = arr[i];
-            if (vi != 0 && values_[vi] == ref) { val_idx = vi; break; }
+        [[maybe_unused]] std::size_t hash = 0;
+        [[maybe_unused]] bool indexed = false;
+        if constexpr (map_wide_) {
+            hash = std::hash<T>{}(ref);
+            auto it = index_.find(hash);
+            if (it == index_.end()) {
+                indexed = true;
+            } else {
+                if (values_[it->second] == ref) return it->second;
+                if (const int vi = scan(ref)) return vi;
+            }
+        } else {
+            if (const int vi = scan(ref)) return vi;
         }
-        if (val_idx == 0) {
-            values_.push_back(std::forward<U>(val));
-            val_idx = static_cast<int>(values_.size() - 1);
+        // Index 0 marks empty slots; its entry is created with the first value.
+        if (values_.empty()) values_.emplace_back();
+        values_.push_back(std::forward<U>(val));
+        const int vi = static_cast<int>(values_.size() - 1);
+        if constexpr (map_wide_) {
+            if (indexed) index_.emplace(hash, vi);
         }
-        if (arr[bit] == 0) ++size_;
-        arr[bit] = val_idx;
+        return vi;
     }
     /// @brief Value index at key or 0 if empty.
     int value_index_at(size_type key) const noexcept {
@@ -412,137 +683,275 @@ private:
         return buckets_[idx][bit];
     }
 
+    /// @brief Bit mask of occupied entries of bucket idx, 0 past the end.
+    Bucket occupancy(size_type idx) const {
+        if (idx >= buckets_.size()) return 0;
+        return mask_from_bitset<Bucket>(buckets_.occupancy(idx));
+    }
+
+    /// @brief Index in values_ of a copy of src.values_[vi], copying on first use.
+    int adopt(const bucket_map& src, int vi, std::vector<int>& remap) {
+        if (remap[vi] == 0) remap[vi] = intern(src.values_[vi], [](const T&) { return 0; });
+        return remap[vi];
+    }
+
+    /// @brief Fill the slots in add from rhs bucket src, sharing equal values held by the slots in keep.
+    void adopt_bucket(std::array<int, bits_>& slots, const Bucket& keep, const Bucket& add,
+                      const std::array<int, bits_>& src, const bucket_map& rhs,
+                      std::vector<int>& remap) {
+        std::array<std::pair<int, int>, bits_> seen{};
+        size_type seen_count = 0;
+        for_each_set_bit(add, [&](std::size_t bit) {
+            const int rvi = src[bit];
+            int vi = 0;
+            for (size_type i = 0; i < seen_count && vi == 0; ++i)
+                if (seen[i].first == rvi) vi = seen[i].second;
+            if (vi == 0) {
+                // A bucket must not hold two indices of equal values.
+                for_each_set_bit(keep, [&](std::size_t kbit) {
+                    if (vi == 0 && values_[slots[kbit]] == rhs.values_[rvi]) vi = slots[kbit];
+                });
+                if (vi == 0) vi = adopt(rhs, rvi, remap);
+                seen[seen_count++] = {rvi, vi};
+            }
+            slots[bit] = vi;
+        });
+    }
+
+    /// @brief Bucket index meaning no bucket is loaded.
+    static constexpr size_type npos_bucket = static_cast<size_type>(-1);
+
     /// @brief Total key capacity.
     size_type capacity() const noexcept { return buckets_.size() * bits_; }
 
     /// @brief Packed arrays storing value indices per bucket.
     flat_vector<bucket_array> buckets_{};
-    /// @brief Vector storing unique values.
+    /// @brief Vector storing unique values; entry 0 stands for empty slots once anything is stored.
     std::vector<T> values_{};
+    struct no_index {};
+    /// @brief Value hash to index of the first stored value with that hash (map_dedup only).
+    [[no_unique_address]] std::conditional_t<map_wide_, std::unordered_map<std::size_t, int>, no_index> index_{};
     /// @brief Current number of stored keys.
     size_type size_{0};
 };
 
-template<typename Key, typename T, typename Bucket>
-Bucket bucket_map<Key, T, Bucket>::mask_of(const bucket_array& arr)
+template<typename Key, typename T, typename Bucket, typename Dedup>
+auto bucket_map<Key, T, Bucket, Dedup>::compact() -> size_type
 {
-    Bucket mask{};
-    for (std::size_t bit = 0; bit < bits_; ++bit)
-        if (arr[bit] != 0) mask |= Bucket{1} << bit;
-    return mask;
+    if (values_.empty()) return 0;
+    const size_type before = values_.size();
+    std::vector<int> remap(values_.size(), 0);
+    std::vector<T> live;
+    live.push_back(T{});
+    flat_vector<bucket_array> packed;
+    size_type used = 0;
+    for (size_type b = 0; b < buckets_.size(); ++b) {
+        std::array<int, bits_> slots{};
+        if (buckets_.planes(b) != 0) {
+            slots = buckets_.unpack(b);
+            for (int& vi : slots) {
+                if (vi == 0) continue;
+                if (remap[vi] == 0) {
+                    live.push_back(std::move(values_[vi]));
+                    remap[vi] = static_cast<int>(live.size() - 1);
+                }
+                vi = remap[vi];
+            }
+        }
+        packed.push_back(slots);
+        if (packed.planes(b) != 0) used = b + 1;
+    }
+    packed.resize(used);
+    buckets_ = std::move(packed);
+    values_ = std::move(live);
+    if constexpr (map_wide_) {
+        index_.clear();
+        for (size_type vi = 1; vi < values_.size(); ++vi)
+            index_.try_emplace(std::hash<T>{}(values_[vi]), static_cast<int>(vi));
+    }
+    return before - values_.size();
+}
+
+template<typename Key, typename T, typename Bucket, typename Dedup>
+template<set_op Op>
+bucket_map<Key, T, Bucket, Dedup> bucket_map<Key, T, Bucket, Dedup>::combine(const bucket_map& lhs,
+                                                                            const bucket_map& rhs)
+{
+    constexpr bool lhs_only = Op == set_op::overlap || Op == set_op::subtract;
+    const size_type count = lhs_only ? lhs.buckets_.size()
+                                     : std::max(lhs.buckets_.size(), rhs.buckets_.size());
+    bucket_map out;
+    std::vector<int> lhs_remap(lhs.values_.size(), 0);
+    std::vector<int> rhs_remap(rhs.values_.size(), 0);
+    size_type used = 0;
+    for (size_type b = 0; b < count; ++b) {
+        const Bucket lm = lhs.occupancy(b);
+        const Bucket rm = rhs.occupancy(b);
+        Bucket from_lhs{};
+        Bucket from_rhs{};
+        if constexpr (Op == set_op::overlap)   from_lhs = lm & rm;
+        if constexpr (Op == set_op::subtract)  from_lhs = lm & ~rm;
+        if constexpr (Op == set_op::merge)     { from_lhs = lm; from_rhs = rm & ~lm; }
+        if constexpr (Op == set_op::exclusive) { from_lhs = lm & ~rm; from_rhs = rm & ~lm; }
+
+        std::array<int, bits_> slots{};
+        if (from_lhs) {
+            const auto src = lhs.buckets_.unpack(b);
+            for_each_set_bit(from_lhs, [&](std::size_t bit) {
+                slots[bit] = out.adopt(lhs, src[bit], lhs_remap);
+            });
+        }
+        if (from_rhs) out.adopt_bucket(slots, from_lhs, from_rhs, rhs.buckets_.unpack(b), rhs, rhs_remap);
+        out.buckets_.push_back(slots);
+        if (const Bucket kept = from_lhs | from_rhs) {
+            out.size_ += static_cast<size_type>(mask_popcount(kept));
+            used = b + 1;
+        }
+    }
+    out.buckets_.resize(used);
+    return out;
 }
 
-/// @brief Invoke function for each set bit in a mask.
-template<typename Bucket, typename Fn>
-static void for_each_set_bit(Bucket mask, Fn&& fn)
+template<typename Key, typename T, typename Bucket, typename Dedup>
+template<set_op Op>
+void bucket_map<Key, T, Bucket, Dedup>::combine_with(const bucket_map& rhs)
 {
-    while (mask) {
-        auto bit = std::countr_zero(mask);
-        fn(static_cast<std::size_t>(bit));
-        mask &= mask - 1;
+    if (this == &rhs) {
+        if constexpr (Op == set_op::subtract || Op == set_op::exclusive) clear();
+        return;
+    }
+    const size_type shared = std::min(buckets_.size(), rhs.buckets_.size());
+    if constexpr (Op == set_op::overlap) {
+        for (size_type b = 0; b < buckets_.size(); ++b) {
+            const Bucket drop = occupancy(b) & ~rhs.occupancy(b);
+            size_ -= static_cast<size_type>(mask_popcount(drop));
+            if (drop && b < shared) buckets_.reset(b, mask_to_bitset(drop));
+        }
+        buckets_.resize(shared);
+    } else if constexpr (Op == set_op::subtract) {
+        for (size_type b = 0; b < shared; ++b) {
+            const Bucket drop = occupancy(b) & rhs.occupancy(b);
+            if (!drop) continue;
+            buckets_.reset(b, mask_to_bitset(drop));
+            size_ -= static_cast<size_type>(mask_popcount(drop));
+        }
+    } else {
+        if (rhs.buckets_.size() > buckets_.size()) buckets_.resize(rhs.buckets_.size());
+        std::vector<int> remap(rhs.values_.size(), 0);
+        for (size_type b = 0; b < rhs.buckets_.size(); ++b) {
+            const Bucket rm = rhs.occupancy(b);
+            if (!rm) continue;
+            const Bucket lm = occupancy(b);
+            const Bucket add = rm & ~lm;
+            Bucket keep = lm;
+            if constexpr (Op == set_op::exclusive) {
+                if (const Bucket drop = lm & rm) {
+                    keep &= ~drop;
+                    buckets_.reset(b, mask_to_bitset(drop));
+                    size_ -= static_cast<size_type>(mask_popcount(drop));
+                }
+            }
+            if (!add) continue;
+            auto slots = buckets_.unpack(b);
+            adopt_bucket(slots, keep, add, rhs.buckets_.unpack(b), rhs, remap);
+            buckets_.store(b, slots);
+            size_ += static_cast<size_type>(mask_popcount(add));
+        }
     }
 }
 
-template<typename Key, typename T, typename Bucket>
-auto bucket_map<Key, T, Bucket>::overlap(const bucket_map& lhs,
-                                         const bucket_map& rhs)
+template<typename Key, typename T, typename Bucket, typename Dedup>
+auto bucket_map<Key, T, Bucket, Dedup>::overlap(const bucket_map& lhs,
+                                                const bucket_map& rhs)
 {
-    return views::overlap(lhs, rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::overlap(lhs, rhs, key_less{});
 }
 
-template<typename Key, typename T, typename Bucket>
-auto bucket_map<Key, T, Bucket>::overlap(const bucket_map& rhs)
+template<typename Key, typename T, typename Bucket, typename Dedup>
+auto bucket_map<Key, T, Bucket, Dedup>::overlap(const bucket_map& rhs)
 {
-    return views::overlap(rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::overlap(rhs, key_less{});
 }
 
-template<typename Key, typename T, typename Bucket>
-auto bucket_map<Key, T, Bucket>::subtract(const bucket_map& lhs,
-                                          const bucket_map& rhs)
+template<typename Key, typename T, typename Bucket, typename Dedup>
+auto bucket_map<Key, T, Bucket, Dedup>::subtract(const bucket_map& lhs,
+                                                 const bucket_map& rhs)
 {
-    return views::subtract(lhs, rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::subtract(lhs, rhs, key_less{});
 }
 
-template<typename Key, typename T, typename Bucket>
-auto bucket_map<Key, T, Bucket>::subtract(const bucket_map& rhs)
+template<typename Key, typename T, typename Bucket, typename Dedup>
+auto bucket_map<Key, T, Bucket, Dedup>::subtract(const bucket_map& rhs)
 {
-    return views::subtract(rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::subtract(rhs, key_less{});
 }
 
-template<typename Key, typename T, typename Bucket>
-auto bucket_map<Key, T, Bucket>::merge(const bucket_map& lhs,
-                                       const bucket_map& rhs)
+template<typename Key, typename T, typename Bucket, typename Dedup>
+auto bucket_map<Key, T, Bucket, Dedup>::merge(const bucket_map& lhs,
+                                              const bucket_map& rhs)
 {
-    return views::merge(lhs, rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::merge(lhs, rhs, key_less{});
 }
 
-template<typename Key, typename T, typename Bucket>
-auto bucket_map<Key, T, Bucket>::merge(const bucket_map& rhs)
+template<typename Key, typename T, typename Bucket, typename Dedup>
+auto bucket_map<Key, T, Bucket, Dedup>::merge(const bucket_map& rhs)
 {
-    return views::merge(rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::merge(rhs, key_less{});
 }
 
-template<typename Key, typename T, typename Bucket>
-auto bucket_map<Key, T, Bucket>::exclusive(const bucket_map& lhs,
-                                           const bucket_map& rhs)
+template<typename Key, typename T, typename Bucket, typename Dedup>
+auto bucket_map<Key, T, Bucket, Dedup>::exclusive(const bucket_map& lhs,
+                                                  const bucket_map& rhs)
 {
-    return views::exclusive(lhs, rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::exclusive(lhs, rhs, key_less{});
 }
 
-template<typename Key, typename T, typename Bucket>
-auto bucket_map<Key, T, Bucket>::exclusive(const bucket_map& rhs)
+template<typename Key, typename T, typename Bucket, typename Dedup>
+auto bucket_map<Key, T, Bucket, Dedup>::exclusive(const bucket_map& rhs)
 {
-    return views::exclusive(rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::exclusive(rhs, key_less{});
 }
 
 /// @brief Write entries present in both maps to output iterator.
-template<typename Key, typename T, typename Bucket, typename OutIt>
-OutIt set_intersection(const bucket_map<Key, T, Bucket>& lhs,
-                       const bucket_map<Key, T, Bucket>& rhs,
+template<typename Key, typename T, typename Bucket, typename Dedup, typename OutIt>
+OutIt set_intersection(const bucket_map<Key, T, Bucket, Dedup>& lhs,
+                       const bucket_map<Key, T, Bucket, Dedup>& rhs,
                        OutIt out)
 {
-    for (auto&& e : bucket_map<Key, T, Bucket>::overlap(lhs, rhs))
+    for (auto&& e : bucket_map<Key, T, Bucket, Dedup>::overlap(lhs, rhs))
         *out++ = e;
     return out;
 }
 
 /// @brief Write entries present in lhs but not rhs to output iterator.
-template<typename Key, typename T, typename Bucket, typename OutIt>
-OutIt set_difference(const bucket_map<Key, T, Bucket>& lhs,
-                     const bucket_map<Key, T, Bucket>& rhs,
+template<typename Key, typename T, typename Bucket, typename Dedup, typename OutIt>
+OutIt set_difference(const bucket_map<Key, T, Bucket, Dedup>& lhs,
+                     const bucket_map<Key, T, Bucket, Dedup>& rhs,
                      OutIt out)
 {
-    for (auto&& e : bucket_map<Key, T, Bucket>::subtract(lhs, rhs))
+    for (auto&& e : bucket_map<Key, T, Bucket, Dedup>::subtract(lhs, rhs))
         *out++ = e;
     return out;
 }
 
 /// @brief Write all unique entries from both maps to output iterator.
-template<typename Key, typename T, typename Bucket, typename OutIt>
-OutIt set_union(const bucket_map<Key, T, Bucket>& lhs,
-                const bucket_map<Key, T, Bucket>& rhs,
+template<typename Key, typename T, typename Bucket, typename Dedup, typename OutIt>
+OutIt set_union(const bucket_map<Key, T, Bucket, Dedup>& lhs,
+                const bucket_map<Key, T, Bucket, Dedup>& rhs,
                 OutIt out)
 {
-    for (auto&& e : bucket_map<Key, T, Bucket>::merge(lhs, rhs))
+    for (auto&& e : bucket_map<Key, T, Bucket, Dedup>::merge(lhs, rhs))
         *out++ = e;
     return out;
 }
 
 /// @brief Write elements present in exactly one of the maps.
-template<typename Key, typename T, typename Bucket, typename OutIt>
-OutIt set_symmetric_difference(const bucket_map<Key, T, Bucket>& lhs,
-                               const bucket_map<Key, T, Bucket>& rhs,
+template<typename Key, typename T, typename Bucket, typename Dedup, typename OutIt>
+OutIt set_symmetric_difference(const bucket_map<Key, T, Bucket, Dedup>& lhs,
+                               const bucket_map<Key, T, Bucket, Dedup>& rhs,
                                OutIt out)
 {
-    for (auto&& e : bucket_map<Key, T, Bucket>::exclusive(lhs, rhs))
+    for (auto&& e : bucket_map<Key, T, Bucket, Dedup>::exclusive(lhs, rhs))
         *out++ = e;
     return out;
 }
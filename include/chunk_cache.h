@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Hit and miss counters of a chunk_cache.
+struct chunk_cache_stats {
+    /// @brief Lookups answered from the cache.
+    std::size_t hits{0};
+    /// @brief Lookups that fell through to the outer map.
+    std::size_t misses{0};
+
+    /// @brief Fraction of lookups answered from the cache, 0 if none were made.
+    double hit_rate() const noexcept {
+        auto total = hits + misses;
+        return total ? static_cast<double>(hits) / static_cast<double>(total) : 0.0;
+    }
+};
+
+/**
+ * @brief Small most-recently-used cache of outer map iterators.
+ *
+ * Entries are keyed by chunk Morton code and kept in recency order, so
+ * the first slot doubles as a last-chunk pointer and the rest form a
+ * tiny LRU. Copying or moving never transfers cached iterators: the
+ * destination and the moved-from source both start empty, because the
+ * iterators refer to the source container.
+ *
+ * Every clear() also bumps a generation count, so code holding raw
+ * pointers into the container can tell when they may have gone stale.
+ */
+template<typename Iterator, std::size_t Ways = 4>
+class chunk_cache {
+    static_assert(Ways >= 1, "chunk_cache needs at least one way");
+public:
+    /// @brief Construct empty cache.
+    chunk_cache() = default;
+    /// @brief Copying yields an empty cache.
+    chunk_cache(const chunk_cache&) noexcept {}
+    /// @brief Moving yields an empty cache and empties the source.
+    chunk_cache(chunk_cache&& other) noexcept { other.clear(); }
+    /// @brief Copy assignment empties the cache.
+    chunk_cache& operator=(const chunk_cache&) noexcept { clear(); return *this; }
+    /// @brief Move assignment empties both caches.
+    chunk_cache& operator=(chunk_cache&& other) noexcept { clear(); other.clear(); return *this; }
+
+    /// @brief Cached iterator for code moved to the front, or nullptr on a miss.
+    const Iterator* find(std::uint64_t code) noexcept {
+        for (std::size_t i = 0; i < used_; ++i) {
+            if (codes_[i] != code) continue;
+            if (i != 0) {
+                std::rotate(codes_.begin(), codes_.begin() + i, codes_.begin() + i + 1);
+                std::rotate(its_.begin(), its_.begin() + i, its_.begin() + i + 1);
+            }
+            ++stats_.hits;
+            return &its_[0];
+        }
+        ++stats_.misses;
+        return nullptr;
+    }
+
+    /// @brief Insert code at the front, evicting the least recently used entry.
+    void insert(std::uint64_t code, Iterator it) noexcept {
+        std::size_t last = used_ < Ways ? used_ : Ways - 1;
+        std::shift_right(codes_.begin(), codes_.begin() + last + 1, 1);
+        std::shift_right(its_.begin(), its_.begin() + last + 1, 1);
+        codes_[0] = code;
+        its_[0] = it;
+        if (used_ < Ways) ++used_;
+    }
+
+    /// @brief Drop every cached iterator and bump the generation; counters are kept.
+    void clear() noexcept { used_ = 0; ++generation_; }
+
+    /// @brief Number of clear() calls since construction.
+    std::uint64_t generation() const noexcept { return generation_; }
+
+    /// @brief Hit and miss counters since construction or reset_stats().
+    chunk_cache_stats stats() const noexcept { return stats_; }
+    /// @brief Zero the hit and miss counters.
+    void reset_stats() noexcept { stats_ = {}; }
+
+private:
+    /// @brief Chunk codes in recency order.
+    std::array<std::uint64_t, Ways> codes_{};
+    /// @brief Outer iterators matching codes_.
+    std::array<Iterator, Ways> its_{};
+    /// @brief Number of valid entries.
+    std::size_t used_{0};
+    /// @brief Hit and miss counters.
+    chunk_cache_stats stats_{};
+    /// @brief Bumped by clear().
+    std::uint64_t generation_{0};
+};
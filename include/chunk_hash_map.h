@@ -0,0 +1,389 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <utility>
+#include <tuple>
+#include <iterator>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Open-addressing hash map keyed by chunk positions.
+ *
+ * Designed as a drop in `OuterMap` for chunk_map. Keys must expose a
+ * Morton code through `encode()` (ChunkPosition or the cached ChunkKey).
+ * Values are stored in place inside a linear probing table and the slot
+ * is chosen with Fibonacci hashing of the Morton code, which scatters
+ * the nearly consecutive codes of neighbouring chunks across the table.
+ *
+ * Iteration visits entries in Morton order through a sorted slot index
+ * that is rebuilt lazily after new keys are inserted, so ordered set
+ * operations keep working; erasing patches the index in place. Building
+ * the index mutates internal caches, so concurrent iteration of a shared
+ * map needs external locking.
+ * Inserting new keys or erasing keys invalidates iterators and references;
+ * looking up or re-emplacing an existing key never moves entries.
+ */
+template<typename Key, typename T>
+class chunk_hash_map {
+public:
+    /// @brief Key type used for lookup.
+    using key_type    = Key;
+    /// @brief Value type stored per key.
+    using mapped_type = T;
+    /// @brief Key/value pair stored in each slot.
+    using value_type  = std::pair<const Key, T>;
+    /// @brief Size type of the container.
+    using size_type   = std::size_t;
+
+    class iterator;
+    class const_iterator;
+
+    /// @brief Construct empty map without allocating.
+    chunk_hash_map() = default;
+    /// @brief Copy every entry and the cached order.
+    chunk_hash_map(const chunk_hash_map&) = default;
+    /// @brief Move construct by taking the table, leaving other empty.
+    chunk_hash_map(chunk_hash_map&& other) noexcept
+        : slots_(std::move(other.slots_)), size_(std::exchange(other.size_, 0)),
+          shift_(std::exchange(other.shift_, 64)), order_(std::move(other.order_)),
+          rank_(std::move(other.rank_)), head_(std::exchange(other.head_, 0)),
+          dead_(std::exchange(other.dead_, 0)),
+          order_valid_(std::exchange(other.order_valid_, false)) {}
+    /// @brief Copy assign through copy and swap; entries hold const keys.
+    chunk_hash_map& operator=(const chunk_hash_map& other) {
+        if (this != &other) *this = chunk_hash_map(other);
+        return *this;
+    }
+    /// @brief Move assign by taking the table, leaving other empty.
+    chunk_hash_map& operator=(chunk_hash_map&& other) noexcept {
+        slots_ = std::move(other.slots_);
+        size_ = std::exchange(other.size_, 0);
+        shift_ = std::exchange(other.shift_, 64);
+        order_ = std::move(other.order_);
+        rank_ = std::move(other.rank_);
+        head_ = std::exchange(other.head_, 0);
+        dead_ = std::exchange(other.dead_, 0);
+        order_valid_ = std::exchange(other.order_valid_, false);
+        return *this;
+    }
+
+    /// @brief True if no keys are stored.
+    bool empty() const noexcept { return size_ == 0; }
+    /// @brief Number of stored keys.
+    size_type size() const noexcept { return size_; }
+    /// @brief Number of slots in the table.
+    size_type capacity() const noexcept { return slots_.size(); }
+
+    /// @brief Remove all keys and release the table.
+    void clear() noexcept {
+        slots_.clear();
+        size_ = 0;
+        shift_ = 64;
+        invalidate_order();
+    }
+
+    /// @brief Grow the table so n keys fit without rehashing.
+    void reserve(size_type n) {
+        size_type cap = 16;
+        while (cap * max_load_num < n * max_load_den) cap *= 2;
+        if (cap > slots_.size()) rehash(cap);
+    }
+
+    /// @brief Iterator to key or end().
+    iterator find(const Key& key) { return iterator(this, find_slot(key)); }
+    /// @brief Const iterator to key or end().
+    const_iterator find(const Key& key) const { return const_iterator(this, find_slot(key)); }
+    /// @brief True if key is stored.
+    bool contains(const Key& key) const { return find_slot(key) != npos; }
+    /// @brief Iterator to the first key whose Morton code is not below key's, or end().
+    iterator lower_bound(const Key& key) { return iterator(this, lower_bound_slot(key)); }
+    /// @brief Const iterator to the first key whose Morton code is not below key's, or end().
+    const_iterator lower_bound(const Key& key) const { return const_iterator(this, lower_bound_slot(key)); }
+
+    /// @brief Insert value constructed from args if key is missing.
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        if (auto slot = find_slot(key); slot != npos) return {iterator(this, slot), false};
+        if (slots_.empty() || (size_ + 1) * max_load_den > slots_.size() * max_load_num)
+            rehash(slots_.empty() ? 16 : slots_.size() * 2);
+        const size_type mask = slots_.size() - 1;
+        size_type i = home(key);
+        while (slots_[i]) i = (i + 1) & mask;
+        slots_[i].emplace(std::piecewise_construct,
+                          std::forward_as_tuple(key),
+                          std::forward_as_tuple(std::forward<Args>(args)...));
+        ++size_;
+        invalidate_order();
+        return {iterator(this, i), true};
+    }
+
+    /// @brief Access value, inserting a default one if missing.
+    T& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    /// @brief Access existing value or throw std::out_of_range.
+    T& at(const Key& key) {
+        auto slot = find_slot(key);
+        if (slot == npos) throw std::out_of_range("chunk_hash_map::at");
+        return slots_[slot]->second;
+    }
+    /// @brief Access existing value or throw std::out_of_range (const).
+    const T& at(const Key& key) const {
+        auto slot = find_slot(key);
+        if (slot == npos) throw std::out_of_range("chunk_hash_map::at");
+        return slots_[slot]->second;
+    }
+
+    /// @brief Erase key and return count removed.
+    size_type erase(const Key& key) {
+        auto slot = find_slot(key);
+        if (slot == npos) return 0;
+        erase_slot(slot);
+        return 1;
+    }
+
+    /// @brief Erase entry and return iterator to the next one in Morton order.
+    iterator erase(const_iterator pos) {
+        const size_type next = next_slot(pos.slot_);
+        if (next == npos) {
+            erase_slot(pos.slot_);
+            return end();
+        }
+        Key key = slots_[next]->first;
+        erase_slot(pos.slot_);
+        return find(key);
+    }
+
+    /// @brief Iterator to the entry with the smallest Morton code.
+    iterator begin() { return iterator(this, first_slot()); }
+    /// @brief Iterator past the last entry.
+    iterator end() noexcept { return iterator(this, npos); }
+    /// @brief Const iterator to the entry with the smallest Morton code.
+    const_iterator begin() const { return cbegin(); }
+    /// @brief Const iterator past the last entry.
+    const_iterator end() const noexcept { return cend(); }
+    /// @brief Const iterator to the entry with the smallest Morton code.
+    const_iterator cbegin() const { return const_iterator(this, first_slot()); }
+    /// @brief Const iterator past the last entry.
+    const_iterator cend() const noexcept { return const_iterator(this, npos); }
+
+    /// @brief Forward iterator over mutable entries in Morton order.
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using iterator_concept  = std::forward_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = chunk_hash_map::value_type;
+        using reference         = value_type&;
+        using pointer           = value_type*;
+
+        /// @brief Default constructed iterator.
+        iterator() = default;
+        /// @brief Construct from parent and slot.
+        iterator(chunk_hash_map* m, size_type slot) : map_(m), slot_(slot) {}
+
+        /// @brief Dereference to stored pair.
+        reference operator*() const { return *map_->slots_[slot_]; }
+        /// @brief Member access to stored pair.
+        pointer operator->() const { return &*map_->slots_[slot_]; }
+        /// @brief Advance to the next key in Morton order.
+        iterator& operator++() { slot_ = map_->next_slot(slot_); return *this; }
+        /// @brief Post-increment iterator.
+        iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+        /// @brief Equality comparison.
+        bool operator==(const iterator& o) const { return slot_ == o.slot_; }
+
+    private:
+        chunk_hash_map* map_{}; ///< @brief Parent container pointer.
+        size_type slot_{npos};  ///< @brief Current slot or npos at end.
+        friend class chunk_hash_map;
+        friend class const_iterator;
+    };
+
+    /// @brief Forward iterator over constant entries in Morton order.
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using iterator_concept  = std::forward_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = chunk_hash_map::value_type;
+        using reference         = const value_type&;
+        using pointer           = const value_type*;
+
+        /// @brief Default constructed iterator.
+        const_iterator() = default;
+        /// @brief Construct from parent and slot.
+        const_iterator(const chunk_hash_map* m, size_type slot) : map_(m), slot_(slot) {}
+        /// @brief Convert from mutable iterator.
+        const_iterator(iterator it) : map_(it.map_), slot_(it.slot_) {}
+
+        /// @brief Dereference to stored pair.
+        reference operator*() const { return *map_->slots_[slot_]; }
+        /// @brief Member access to stored pair.
+        pointer operator->() const { return &*map_->slots_[slot_]; }
+        /// @brief Advance to the next key in Morton order.
+        const_iterator& operator++() { slot_ = map_->next_slot(slot_); return *this; }
+        /// @brief Post-increment iterator.
+        const_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+        /// @brief Equality comparison.
+        bool operator==(const const_iterator& o) const { return slot_ == o.slot_; }
+
+    private:
+        const chunk_hash_map* map_{}; ///< @brief Parent container pointer.
+        size_type slot_{npos};        ///< @brief Current slot or npos at end.
+        friend class chunk_hash_map;
+    };
+
+private:
+    /// @brief Slot index used for end iterators and failed lookups.
+    static constexpr size_type npos = static_cast<size_type>(-1);
+    /// @brief Maximum load factor numerator.
+    static constexpr size_type max_load_num = 3;
+    /// @brief Maximum load factor denominator.
+    static constexpr size_type max_load_den = 4;
+
+    /// @brief Preferred slot of key: Fibonacci hash of its Morton code.
+    size_type home(const Key& key) const noexcept {
+        std::uint64_t code = static_cast<std::uint64_t>(key.encode());
+        return static_cast<size_type>((code * 0x9e3779b97f4a7c15ull) >> shift_);
+    }
+
+    /// @brief Slot holding key or npos.
+    size_type find_slot(const Key& key) const {
+        if (slots_.empty()) return npos;
+        const size_type mask = slots_.size() - 1;
+        for (size_type i = home(key);; i = (i + 1) & mask) {
+            if (!slots_[i]) return npos;
+            if (slots_[i]->first == key) return i;
+        }
+    }
+
+    /// @brief Remove slot content using backward shift deletion.
+    ///
+    /// A valid Morton order survives: the erased rank becomes a hole and
+    /// entries moved by the shift have their order_ and rank_ entries
+    /// patched, so erasing while iterating never re-sorts.
+    void erase_slot(size_type slot) {
+        const size_type mask = slots_.size() - 1;
+        slots_[slot].reset();
+        if (order_valid_) {
+            order_[rank_[slot]] = npos;
+            rank_[slot] = npos;
+            ++dead_;
+        }
+        for (size_type j = (slot + 1) & mask; slots_[j]; j = (j + 1) & mask) {
+            size_type h = home(slots_[j]->first);
+            if (((j - h) & mask) >= ((j - slot) & mask)) {
+                slots_[slot].emplace(std::move(*slots_[j]));
+                slots_[j].reset();
+                if (order_valid_) {
+                    order_[rank_[j]] = slot;
+                    rank_[slot] = std::exchange(rank_[j], npos);
+                }
+                slot = j;
+            }
+        }
+        --size_;
+        if (order_valid_ && dead_ > size_) compact_order();
+    }
+
+    /// @brief Move all entries into a table with new_cap slots.
+    void rehash(size_type new_cap) {
+        std::vector<std::optional<value_type>> old(new_cap);
+        old.swap(slots_);
+        shift_ = 64 - static_cast<unsigned>(std::countr_zero(new_cap));
+        const size_type mask = new_cap - 1;
+        for (auto& e : old) {
+            if (!e) continue;
+            size_type i = home(e->first);
+            while (slots_[i]) i = (i + 1) & mask;
+            slots_[i].emplace(std::move(*e));
+        }
+        invalidate_order();
+    }
+
+    /// @brief Drop the cached Morton order.
+    void invalidate_order() noexcept { order_valid_ = false; }
+
+    /// @brief Rebuild the sorted slot index if the key set changed.
+    void ensure_order() const {
+        if (order_valid_) return;
+        order_.clear();
+        for (size_type i = 0; i < slots_.size(); ++i)
+            if (slots_[i]) order_.push_back(i);
+        std::ranges::sort(order_, {}, [this](size_type i) { return slots_[i]->first.encode(); });
+        rank_.assign(slots_.size(), npos);
+        for (size_type r = 0; r < order_.size(); ++r) rank_[order_[r]] = r;
+        head_ = 0;
+        dead_ = 0;
+        order_valid_ = true;
+    }
+
+    /// @brief Drop the holes left in order_ by erase without re-sorting.
+    void compact_order() {
+        std::erase(order_, npos);
+        for (size_type r = 0; r < order_.size(); ++r) rank_[order_[r]] = r;
+        head_ = 0;
+        dead_ = 0;
+    }
+
+    /// @brief First occupied slot at or after rank r in Morton order, or npos.
+    size_type live_from(size_type r) const {
+        while (r < order_.size() && order_[r] == npos) ++r;
+        return r < order_.size() ? order_[r] : npos;
+    }
+
+    /// @brief Slot of the first key not below key in Morton order, or npos.
+    ///
+    /// Binary search over the sorted index; a hole left by erase compares
+    /// like the next live entry, which keeps the search monotone.
+    size_type lower_bound_slot(const Key& key) const {
+        ensure_order();
+        const std::uint64_t code = static_cast<std::uint64_t>(key.encode());
+        size_type lo = head_, hi = order_.size();
+        while (lo < hi) {
+            const size_type mid = lo + (hi - lo) / 2;
+            const size_type slot = live_from(mid);
+            if (slot != npos && static_cast<std::uint64_t>(slots_[slot]->first.encode()) < code)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return live_from(lo);
+    }
+
+    /// @brief Slot with the smallest Morton code or npos.
+    size_type first_slot() const {
+        ensure_order();
+        while (head_ < order_.size() && order_[head_] == npos) ++head_;
+        return head_ < order_.size() ? order_[head_] : npos;
+    }
+
+    /// @brief Slot following slot in Morton order or npos.
+    size_type next_slot(size_type slot) const {
+        ensure_order();
+        return live_from(rank_[slot] + 1);
+    }
+
+    /// @brief Table of in-place stored entries.
+    std::vector<std::optional<value_type>> slots_{};
+    /// @brief Number of stored keys.
+    size_type size_{0};
+    /// @brief Right shift turning a 64-bit hash into a slot index.
+    unsigned shift_{64};
+    /// @brief Occupied slots sorted by Morton code.
+    mutable std::vector<size_type> order_{};
+    /// @brief Position of each slot inside order_.
+    mutable std::vector<size_type> rank_{};
+    /// @brief Rank in order_ before which every entry is a hole.
+    mutable size_type head_{0};
+    /// @brief Number of holes left in order_ by erase.
+    mutable size_type dead_{0};
+    /// @brief True while order_ and rank_ match the key set.
+    mutable bool order_valid_{false};
+};
@@ -10,17 +10,24 @@
 #include <compare>
 #include <stdexcept>
 #include <utility>
+#include <ranges>
 #include <cstddef>
+#include <cassert>
+#include <array>
 
 #include "arrow_proxy.h"
+#include "chunk_cache.h"
 #include "positions.h"
+#include "morton_simd.h"
+#include "radix_sort.h"
 #include "set_views.h"
     
 
 template <
     typename T,
     typename InnerMap = std::map<LocalPosition, T>,
-    typename OuterMap = std::map<ChunkPosition, InnerMap>
+    typename OuterMap = std::map<ChunkKey, InnerMap>,
+    std::uint32_t ChunkEdge = 32
 >
 class chunk_map {
 public:
@@ -28,6 +35,18 @@ public:
     using mapped_type     = T;
     using value_type      = std::pair<const GlobalPosition, T>;
     using size_type       = std::size_t;
+    /// @brief Map holding the voxels of one chunk.
+    using chunk_type      = InnerMap;
+    /// @brief Split and combine helpers for the chunk edge of this map.
+    using geometry        = chunk_geometry<ChunkEdge>;
+
+    /// @brief Voxels along each chunk axis.
+    static constexpr std::uint32_t chunk_edge = ChunkEdge;
+
+    /// @brief Chunk holding a global position.
+    static constexpr ChunkPosition chunk_of(const GlobalPosition& gp) { return geometry::chunk_of(gp); }
+    /// @brief Position of a global position inside its chunk.
+    static constexpr LocalPosition local_of(const GlobalPosition& gp) { return geometry::local_of(gp); }
 
     // Nested iterator types
     class iterator;
@@ -51,6 +70,7 @@ public:
     /** Removes all elements (all chunks). */
     void clear() noexcept {
         chunks_.clear();
+        cache_.clear();
     }
 
     /** 
@@ -61,7 +81,7 @@ public:
     /// @brief Access element, creating chunk/local entry if needed.
     decltype(auto) operator[](const GlobalPosition& gp) {
         auto [cp, lp] = split(gp);
-        InnerMap& inner = chunks_[cp];
+        InnerMap& inner = emplace_chunk(cp)->second;
         return inner[lp];
     }
 
@@ -72,7 +92,7 @@ public:
     /// @brief Access existing element or throw.
     decltype(auto) at(const GlobalPosition& gp) {
         auto [cp, lp] = split(gp);
-        auto itChunk = chunks_.find(cp);
+        typename OuterMap::const_iterator itChunk = find_chunk(cp);
         if (itChunk == chunks_.end())
             throw std::out_of_range("chunk_map::at: chunk not found");
         auto itLocal = itChunk->second.find(lp);
@@ -83,7 +103,7 @@ public:
     /** const overload of at() */
     decltype(auto) at(const GlobalPosition& gp) const {
         auto [cp, lp] = split(gp);
-        auto itChunk = chunks_.find(cp);
+        typename OuterMap::const_iterator itChunk = find_chunk(cp);
         if (itChunk == chunks_.end())
             throw std::out_of_range("chunk_map::at: chunk not found");
         auto itLocal = itChunk->second.find(lp);
@@ -98,7 +118,7 @@ public:
      */
     iterator find(const GlobalPosition& gp) {
         auto [cp, lp] = split(gp);
-        auto itChunk = chunks_.find(cp);
+        auto itChunk = find_chunk(cp);
         if (itChunk == chunks_.end()) return end();
         auto itLocal = itChunk->second.find(lp);
         if (itLocal == itChunk->second.end()) return end();
@@ -107,7 +127,7 @@ public:
     /** const overload of find() */
     const_iterator find(const GlobalPosition& gp) const {
         auto [cp, lp] = split(gp);
-        auto itChunk = chunks_.find(cp);
+        typename OuterMap::const_iterator itChunk = find_chunk(cp);
         if (itChunk == chunks_.end()) return cend();
         auto itLocal = itChunk->second.find(lp);
         if (itLocal == itChunk->second.end()) return cend();
@@ -117,8 +137,7 @@ public:
     /// @brief Insert value if key not present.
     std::pair<iterator, bool> insert(const value_type& v) {
         auto [cp, lp] = split(v.first);
-        auto [outerIt, outerInserted] = chunks_.try_emplace(cp);
-        (void)outerInserted;
+        auto outerIt = emplace_chunk(cp);
         bool existed = outerIt->second.contains(lp);
         if (!existed) outerIt->second.insert_or_assign(lp, v.second);
         auto innerIt = outerIt->second.find(lp);
@@ -128,8 +147,7 @@ public:
     /// @brief Insert movable value if key not present.
     std::pair<iterator, bool> insert(value_type&& v) {
         auto [cp, lp] = split(v.first);
-        auto [outerIt, outerInserted] = chunks_.try_emplace(cp);
-        (void)outerInserted;
+        auto outerIt = emplace_chunk(cp);
         bool existed = outerIt->second.contains(lp);
         if (!existed) outerIt->second.insert_or_assign(lp, std::move(v.second));
         auto innerIt = outerIt->second.find(lp);
@@ -146,18 +164,41 @@ public:
         return insert(std::move(v)).first;
     }
 
+    /**
+     * Insert every element of a range whose key is not yet present.
+     * Keys are Morton encoded in SIMD batches and radix sorted, so each
+     * chunk is looked up once and receives its keys as one sorted run.
+     * Duplicate keys in the range keep the first value, like insert().
+     */
+    template<std::ranges::input_range R>
+    void insert_range(R&& range) {
+        bulk_write<false>(std::forward<R>(range));
+    }
+
+    /**
+     * Insert or assign every element of a range; duplicate keys keep the
+     * last value, like operator[]. Meant for input already in Morton
+     * order, such as set views over chunk maps, which is detected and not
+     * re-sorted; other input is radix sorted first.
+     */
+    template<std::ranges::input_range R>
+    void assign_sorted(R&& range) {
+        bulk_write<true>(std::forward<R>(range));
+    }
+
     /** 
      * Erase the element at GlobalPosition. Returns number of elements removed (0 or 1).
      */
     size_type erase(const GlobalPosition& gp) {
         auto [cp, lp] = split(gp);
-        auto itChunk = chunks_.find(cp);
+        auto itChunk = find_chunk(cp);
         if (itChunk == chunks_.end()) return 0;
         auto itLocal = itChunk->second.find(lp);
         if (itLocal == itChunk->second.end()) return 0;
         itChunk->second.erase(lp);
         if (itChunk->second.empty()) {
             chunks_.erase(itChunk);
+            cache_.clear();
         }
         return 1;
     }
@@ -195,6 +236,63 @@ public:
     /// @brief End iterator for constant map.
     const_iterator end() const { return cend(); }
 
+    /// @brief Iterator to the first voxel not before gp in iteration order.
+    iterator lower_bound(GlobalPosition gp) { return begin().seek(gp); }
+    /// @brief Const iterator to the first voxel not before gp in iteration order.
+    const_iterator lower_bound(GlobalPosition gp) const { return cbegin().seek(gp); }
+
+    template<bool Mutable> class basic_neighbourhood;
+    /// @brief Writable accessor pinning the 3x3x3 chunks around a chunk.
+    using neighbourhood_accessor = basic_neighbourhood<true>;
+    /// @brief Read-only accessor pinning the 3x3x3 chunks around a chunk.
+    using const_neighbourhood_accessor = basic_neighbourhood<false>;
+
+    /// @brief Unpinned writable accessor; call recentre() before use.
+    neighbourhood_accessor neighbourhood() { return neighbourhood_accessor(this); }
+    /// @brief Writable accessor pinned around chunk c.
+    neighbourhood_accessor neighbourhood(ChunkPosition c) { return neighbourhood_accessor(this, c); }
+    /// @brief Unpinned read-only accessor; call recentre() before use.
+    const_neighbourhood_accessor neighbourhood() const { return const_neighbourhood_accessor(this); }
+    /// @brief Read-only accessor pinned around chunk c.
+    const_neighbourhood_accessor neighbourhood(ChunkPosition c) const { return const_neighbourhood_accessor(this, c); }
+
+    /// @brief Hit and miss counters of the hot-chunk cache.
+    chunk_cache_stats cache_stats() const noexcept { return cache_.stats(); }
+    /// @brief Zero the hot-chunk cache counters.
+    void reset_cache_stats() noexcept { cache_.reset_stats(); }
+
+    /// @brief Compact every chunk whose map supports it and erase empty chunks.
+    void compact() {
+        for (auto it = chunks_.begin(); it != chunks_.end();) {
+            if constexpr (requires { it->second.compact(); }) it->second.compact();
+            if (it->second.empty()) it = chunks_.erase(it);
+            else ++it;
+        }
+        cache_.clear();
+    }
+
+    /// @brief Voxels of chunk c, or nullptr if the chunk is not stored.
+    const InnerMap* chunk(ChunkPosition c) const {
+        auto it = find_chunk(chunk_key{c});
+        return it == chunks_.end() ? nullptr : &it->second;
+    }
+
+    /// @brief Call fn(ChunkPosition, const InnerMap&) for every stored chunk in Morton order.
+    template<typename Fn>
+    void for_each_chunk(Fn&& fn) const {
+        for (auto const& [key, inner] : chunks_) fn(ChunkPosition(key), inner);
+    }
+
+    /// @brief Replace the voxels of chunk c; an empty inner map erases the chunk.
+    void assign_chunk(ChunkPosition c, InnerMap inner) {
+        const chunk_key ck{c};
+        if (inner.empty()) {
+            if (chunks_.erase(ck)) cache_.clear();
+            return;
+        }
+        emplace_chunk(ck)->second = std::move(inner);
+    }
+
     /// @brief Lazy overlap view of two maps.
     static auto overlap(const chunk_map& lhs, const chunk_map& rhs);
     /// @brief Overlap adaptor for piping.
@@ -215,15 +313,191 @@ public:
     /// @brief Exclusive adaptor for piping.
     static auto exclusive(const chunk_map& rhs);
 
+    /**
+     * @brief Eager set operation pairing up chunks before touching voxels.
+     *
+     * Chunks present in only one operand are copied whole or dropped
+     * without visiting their voxels; chunks present in both are combined
+     * by the inner map's own combine<Op>() when it has one (bucket masks
+     * for bucket_map) and by a merge of the two inner maps otherwise. On
+     * shared keys the lhs value wins, as in the lazy views.
+     */
+    template<set_op Op>
+    static chunk_map combine(const chunk_map& lhs, const chunk_map& rhs);
+
+    /**
+     * @brief In-place set operation with rhs, visiting only rhs chunks.
+     *
+     * Merge, subtract and exclusive look up each rhs chunk here, copy it
+     * if it is missing (merge, exclusive) and otherwise update the chunk
+     * in place through the inner map's combine_with<Op>() when it has one.
+     * Chunks emptied by the operation are erased. Overlap has to drop
+     * every chunk of this map that rhs lacks, so it walks this map's
+     * chunks instead. On shared keys this map's value is kept.
+     */
+    template<set_op Op>
+    void combine_with(const chunk_map& rhs);
+
+    /// @brief Set operation Op over two chunks sharing a chunk position.
+    template<set_op Op>
+    static InnerMap combine_chunk(const InnerMap& lhs, const InnerMap& rhs) {
+        if constexpr (requires { InnerMap::template combine<Op>(lhs, rhs); }) {
+            return InnerMap::template combine<Op>(lhs, rhs);
+        } else {
+            InnerMap out;
+            for (auto&& [lp, val] : detail::view_adaptor<Op>{}(lhs, rhs, key_less{}))
+                out.insert_or_assign(lp, val);
+            return out;
+        }
+    }
+
 private:
+    /// @brief Low bits of a global Morton code that address the local position.
+    static constexpr unsigned local_code_bits = geometry::code_bits;
+
     OuterMap chunks_;
         
+    /// @brief Outer key type, either ChunkPosition or a cached ChunkKey.
+    using chunk_key = typename OuterMap::key_type;
+
+    /// @brief Recently used chunks; cleared whenever a chunk is added or removed.
+    /// Const lookups update it too, so a map shared across threads needs locking.
+    mutable chunk_cache<typename OuterMap::iterator> cache_;
+
+    /// @brief Outer iterator to chunk or chunks_.end(), consulting the cache first.
+    typename OuterMap::iterator find_chunk(const chunk_key& ck) const {
+        const std::uint64_t code = ck.encode();
+        if (auto hit = cache_.find(code)) return *hit;
+        // Lookup only; the mutable iterator is needed to share one cache.
+        auto& chunks = const_cast<OuterMap&>(chunks_);
+        auto it = chunks.find(ck);
+        if (it != chunks.end()) cache_.insert(code, it);
+        return it;
+    }
+
+    /// @brief Outer iterator to chunk, creating an empty chunk if missing.
+    typename OuterMap::iterator emplace_chunk(const chunk_key& ck) {
+        const std::uint64_t code = ck.encode();
+        if (auto hit = cache_.find(code)) return *hit;
+        auto [it, inserted] = chunks_.try_emplace(ck);
+        // Some outer maps move entries on insert, so cached iterators go stale.
+        if (inserted) cache_.clear();
+        cache_.insert(code, it);
+        return it;
+    }
+
+    /// @brief Shared body of insert_range (Assign = false) and assign_sorted.
+    template<bool Assign, typename R>
+    void bulk_write(R&& range) {
+        std::vector<GlobalPosition> keys;
+        std::vector<T> vals;
+        if constexpr (std::ranges::sized_range<R>) {
+            keys.reserve(std::ranges::size(range));
+            vals.reserve(std::ranges::size(range));
+        }
+        for (auto&& elem : range) {
+            keys.push_back(std::get<0>(elem));
+            vals.push_back(std::get<1>(std::forward<decltype(elem)>(elem)));
+        }
+
+        std::vector<std::uint64_t> codes(keys.size());
+        morton_encode_batch(keys, codes);
+        const auto order = radix_sort_order(codes);
+
+        // Rvalue reference to a staged value (a proxy for std::vector<bool>).
+        using staged_ref = decltype(std::move(vals[0]));
+        std::vector<std::size_t> picks;
+        auto run = picks | std::views::transform([&](std::size_t idx) {
+            return std::pair<LocalPosition, staged_ref>{local_of(keys[idx]), std::move(vals[idx])};
+        });
+        for (std::size_t i = 0; i < order.size();) {
+            const std::uint64_t chunk_code = codes[order[i]] >> local_code_bits;
+            auto& inner = emplace_chunk(chunk_key{chunk_of(keys[order[i]])})->second;
+            picks.clear();
+            for (; i < order.size() && (codes[order[i]] >> local_code_bits) == chunk_code; ++i) {
+                const auto idx = order[i];
+                if constexpr (Assign) {
+                    // Equal codes are adjacent and in input order; keep the last.
+                    if (i + 1 < order.size() && codes[order[i + 1]] == codes[idx]) continue;
+                    picks.push_back(idx);
+                } else {
+                    if (!picks.empty() && codes[picks.back()] == codes[idx]) continue;
+                    if (!inner.contains(local_of(keys[idx]))) picks.push_back(idx);
+                }
+            }
+            write_run(inner, run);
+        }
+    }
+
+    /// @brief Apply set operation Op to inner with rhs in place.
+    template<set_op Op>
+    static void combine_chunk_with(InnerMap& inner, const InnerMap& rhs) {
+        if constexpr (requires { inner.template combine_with<Op>(rhs); })
+            inner.template combine_with<Op>(rhs);
+        else
+            inner = combine_chunk<Op>(inner, rhs);
+    }
+
+    /**
+     * @brief Move an (outer, inner) iterator pair to the first element not before gp.
+     *
+     * Never moves backwards. Chunks are skipped with the outer map's
+     * lower_bound (std::map, chunk_hash_map and paged_chunk_table all have
+     * one) and voxels with the inner map's lower_bound or seek where they
+     * exist, otherwise by stepping.
+     */
+    template<typename Chunks, typename OuterIt, typename InnerIt>
+    static void seek_in(Chunks& chunks, OuterIt& outer, InnerIt& inner, GlobalPosition gp) {
+        if (outer == chunks.end()) return;
+        const chunk_key ck{chunk_of(gp)};
+        const std::uint64_t code = ck.encode();
+        if (outer->first.encode() < code) {
+            if constexpr (requires { chunks.lower_bound(ck); })
+                outer = chunks.lower_bound(ck);
+            else
+                while (outer != chunks.end() && outer->first.encode() < code) ++outer;
+            if (outer == chunks.end()) return;
+            inner = outer->second.begin();
+        }
+        if (outer->first.encode() == code) {
+            auto& voxels = outer->second;
+            const LocalPosition lp = local_of(gp);
+            if constexpr (requires { voxels.lower_bound(lp); }) {
+                if (inner != voxels.end() && inner->first < lp) inner = voxels.lower_bound(lp);
+            } else if constexpr (requires { inner.seek(lp); }) {
+                inner.seek(lp);
+            } else {
+                while (inner != voxels.end() && inner->first < lp) ++inner;
+            }
+        }
+        while (inner == outer->second.end()) {
+            if (++outer == chunks.end()) return;
+            inner = outer->second.begin();
+        }
+    }
+
+    /// @brief Assign a run of (local position, value) pairs in ascending local order.
+    template<typename Run>
+    static void write_run(InnerMap& inner, Run& run) {
+        if constexpr (requires { inner.assign_sorted(run); }) {
+            inner.assign_sorted(run);
+        } else if constexpr (requires { inner.insert_or_assign(inner.end(), LocalPosition{}, std::declval<T>()); }) {
+            // Each key belongs right after the previous one, so that is the hint.
+            auto hint = inner.end();
+            for (auto&& [lp, val] : run)
+                hint = std::next(inner.insert_or_assign(hint, lp, std::forward<decltype(val)>(val)));
+        } else {
+            for (auto&& [lp, val] : run)
+                inner.insert_or_assign(lp, std::forward<decltype(val)>(val));
+        }
+    }
+
     auto split(GlobalPosition g) const {
-        return std::pair{ ChunkPosition{g}, LocalPosition{g} };
+        return std::pair{ chunk_key{chunk_of(g)}, local_of(g) };
     }
 
     static GlobalPosition combine(ChunkPosition c, LocalPosition l) {
-        return GlobalPosition(c) + GlobalPosition(l);
+        return geometry::combine(c, l);
     }
 
 public:
@@ -266,6 +540,11 @@ public:
         }
         iterator operator++(int)
         { iterator tmp = *this; ++(*this); return tmp; }
+        /// @brief Move to the first element not before gp; never moves backwards.
+        iterator& seek(GlobalPosition gp) {
+            seek_in(parent_->chunks_, outerIt_, innerIt_, gp);
+            return *this;
+        }
         // Equality / inequality
         bool operator==(iterator const& o) const {
             return parent_ == o.parent_
@@ -317,6 +596,11 @@ public:
         }
         const_iterator operator++(int)
         { const_iterator tmp = *this; ++(*this); return tmp; }
+        /// @brief Move to the first element not before gp; never moves backwards.
+        const_iterator& seek(GlobalPosition gp) {
+            seek_in(parent_->chunks_, outerIt_, innerIt_, gp);
+            return *this;
+        }
         bool operator==(const_iterator const& o) const {
             return parent_ == o.parent_
                 && outerIt_ == o.outerIt_
@@ -331,116 +615,378 @@ public:
         typename InnerMap::const_iterator innerIt_;
     }; 
 
+    /**
+     * @brief Accessor resolving stencil reads around one chunk without lookups.
+     *
+     * The 27 chunks of the 3x3x3 block centred on a chunk are looked up
+     * once by recentre(); afterwards a position anywhere in the block maps
+     * to its chunk with shifts and a table index. Positions outside the
+     * block are a precondition violation. The mutable variant can write
+     * through operator[]. Adding or erasing a chunk through the map can
+     * move other chunks (a chunk_hash_map outer rehashes), so the pins
+     * remember the map's chunk generation and are looked up again on the
+     * next access after it changes.
+     */
+    template<bool Mutable>
+    class basic_neighbourhood {
+        using map_pointer   = std::conditional_t<Mutable, chunk_map*, const chunk_map*>;
+        using inner_pointer = std::conditional_t<Mutable, InnerMap*, const InnerMap*>;
+    public:
+        /// @brief Offsets of the six face neighbours: +x, -x, +y, -y, +z, -z.
+        static constexpr std::array<std::array<int, 3>, 6> face_offsets{{
+            {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+        }};
+        /// @brief Offsets of all 26 neighbours, x fastest.
+        static constexpr auto all_offsets = [] {
+            std::array<std::array<int, 3>, 26> out{};
+            std::size_t i = 0;
+            for (int dz = -1; dz <= 1; ++dz)
+                for (int dy = -1; dy <= 1; ++dy)
+                    for (int dx = -1; dx <= 1; ++dx)
+                        if (dx || dy || dz) out[i++] = {dx, dy, dz};
+            return out;
+        }();
+
+        /// @brief Accessor bound to no map.
+        basic_neighbourhood() = default;
+        /// @brief Unpinned accessor over map m.
+        explicit basic_neighbourhood(map_pointer m) : map_(m) {}
+        /// @brief Accessor over map m pinned around chunk c.
+        basic_neighbourhood(map_pointer m, ChunkPosition c) : map_(m) { pin(c); }
+
+        /// @brief True once a block has been pinned.
+        bool pinned() const noexcept { return pinned_; }
+        /// @brief Chunk at the middle of the pinned block.
+        ChunkPosition centre() const noexcept { return centre_; }
+
+        /// @brief Pin the block around c unless it is already pinned.
+        void recentre(ChunkPosition c) {
+            if (!pinned_ || !(c == centre_)) pin(c);
+        }
+
+        /// @brief True if p lies inside the pinned block.
+        bool covers(const GlobalPosition& p) const noexcept {
+            return pinned_ && slot_of(p) >= 0;
+        }
+
+        /// @brief True if p is stored. p must lie inside the pinned block.
+        bool contains(const GlobalPosition& p) const {
+            auto inner = pinned_chunk(p);
+            return inner && inner->contains(local_of(p));
+        }
+
+        /// @brief Value at p or throw std::out_of_range. p must lie inside the pinned block.
+        decltype(auto) at(const GlobalPosition& p) const {
+            auto inner = pinned_chunk(p);
+            if (!inner) throw std::out_of_range("chunk_map::neighbourhood::at: chunk not found");
+            return std::as_const(*inner).at(local_of(p));
+        }
+
+        /// @brief Access p, creating the chunk or entry if needed.
+        decltype(auto) operator[](const GlobalPosition& p) requires Mutable {
+            auto& inner = chunks_[static_cast<std::size_t>(live_slot(p))];
+            if (!inner) {
+                auto [it, inserted] = map_->chunks_.try_emplace(chunk_key{chunk_of(p)});
+                if (inserted) {
+                    // Other chunks may have moved, so drop every cached location.
+                    map_->cache_.clear();
+                    lookup();
+                } else {
+                    inner = &it->second;
+                }
+            }
+            return (*inner)[local_of(p)];
+        }
+
+        /// @brief Call f(position, value) for each stored face neighbour of p.
+        template<typename F>
+        void for_each_neighbour6(const GlobalPosition& p, F&& f) const { visit(p, face_offsets, f); }
+        /// @brief Call f(position, value) for each stored neighbour of p, edges and corners included.
+        template<typename F>
+        void for_each_neighbour26(const GlobalPosition& p, F&& f) const { visit(p, all_offsets, f); }
+
+        /// @brief Number of stored face neighbours of p.
+        std::size_t count_neighbours6(const GlobalPosition& p) const { return count(p, face_offsets); }
+        /// @brief Number of stored neighbours of p, edges and corners included.
+        std::size_t count_neighbours26(const GlobalPosition& p) const { return count(p, all_offsets); }
+
+        /// @brief True if all six face neighbours of p are stored.
+        bool has_all_neighbours6(const GlobalPosition& p) const {
+            for (auto [dx, dy, dz] : face_offsets) {
+                GlobalPosition n;
+                if (!step(p, dx, dy, dz, n) || !contains(n)) return false;
+            }
+            return true;
+        }
+
+    private:
+        /// @brief Look up the 27 chunks around c.
+        void pin(ChunkPosition c) {
+            centre_ = c;
+            pinned_ = true;
+            lookup();
+        }
+
+        /// @brief Refill chunks_ around centre_ and record the map's chunk generation.
+        void lookup() const {
+            generation_ = map_->cache_.generation();
+            const ChunkPosition c = centre_;
+            std::size_t i = 0;
+            for (int dz = -1; dz <= 1; ++dz)
+                for (int dy = -1; dy <= 1; ++dy)
+                    for (int dx = -1; dx <= 1; ++dx, ++i) {
+                        chunks_[i] = nullptr;
+                        std::int64_t x = std::int64_t{c.x} + dx;
+                        std::int64_t y = std::int64_t{c.y} + dy;
+                        std::int64_t z = std::int64_t{c.z} + dz;
+                        if (x < 0 || y < 0 || z < 0) continue;
+                        ChunkPosition n{static_cast<std::uint32_t>(x),
+                                        static_cast<std::uint32_t>(y),
+                                        static_cast<std::uint32_t>(z)};
+                        auto it = map_->chunks_.find(chunk_key{n});
+                        if (it != map_->chunks_.end()) chunks_[i] = &it->second;
+                    }
+        }
+
+        /// @brief Index of the chunk holding p inside chunks_, or -1 outside the block.
+        int slot_of(const GlobalPosition& p) const noexcept {
+            ChunkPosition c = chunk_of(p);
+            std::int64_t dx = std::int64_t{c.x} - centre_.x + 1;
+            std::int64_t dy = std::int64_t{c.y} - centre_.y + 1;
+            std::int64_t dz = std::int64_t{c.z} - centre_.z + 1;
+            if (dx < 0 || dx > 2 || dy < 0 || dy > 2 || dz < 0 || dz > 2) return -1;
+            return static_cast<int>(dz * 9 + dy * 3 + dx);
+        }
+
+        /// @brief Slot of p, re-pinning first if chunks were added or erased since.
+        int live_slot(const GlobalPosition& p) const {
+            auto slot = slot_of(p);
+            assert(pinned_ && slot >= 0 && "position outside the pinned neighbourhood");
+            if (generation_ != map_->cache_.generation()) lookup();
+            return slot;
+        }
+
+        /// @brief Pinned chunk holding p or nullptr if it does not exist.
+        inner_pointer pinned_chunk(const GlobalPosition& p) const {
+            return chunks_[static_cast<std::size_t>(live_slot(p))];
+        }
+
+        /// @brief Offset p by (dx, dy, dz); false if a coordinate would go negative.
+        static bool step(const GlobalPosition& p, int dx, int dy, int dz, GlobalPosition& out) {
+            if ((dx < 0 && p.x == 0) || (dy < 0 && p.y == 0) || (dz < 0 && p.z == 0)) return false;
+            out = GlobalPosition{p.x + dx, p.y + dy, p.z + dz};
+            return true;
+        }
+
+        /// @brief Call f for each stored neighbour of p at the given offsets.
+        template<typename Offsets, typename F>
+        void visit(const GlobalPosition& p, const Offsets& offsets, F& f) const {
+            for (auto [dx, dy, dz] : offsets) {
+                GlobalPosition n;
+                if (!step(p, dx, dy, dz, n)) continue;
+                auto inner = pinned_chunk(n);
+                if (!inner) continue;
+                auto it = inner->find(local_of(n));
+                if (it != inner->end()) f(n, it->second);
+            }
+        }
+
+        /// @brief Number of stored neighbours of p at the given offsets.
+        template<typename Offsets>
+        std::size_t count(const GlobalPosition& p, const Offsets& offsets) const {
+            std::size_t total = 0;
+            for (auto [dx, dy, dz] : offsets) {
+                GlobalPosition n;
+                total += step(p, dx, dy, dz, n) && contains(n);
+            }
+            return total;
+        }
+
+        map_pointer map_{};                    ///< @brief Accessed map.
+        mutable std::array<inner_pointer, 27> chunks_{}; ///< @brief Pinned chunks, x fastest, null if absent.
+        mutable std::uint64_t generation_{0};  ///< @brief Map chunk generation chunks_ was filled at.
+        ChunkPosition centre_{};               ///< @brief Centre of the pinned block.
+        bool pinned_{false};                   ///< @brief True once pin() ran.
+    };
+
 };
 
-template<typename T, typename InnerMap, typename OuterMap>
-auto chunk_map<T, InnerMap, OuterMap>::overlap(const chunk_map& lhs,
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E>
+template<set_op Op>
+chunk_map<T, InnerMap, OuterMap, E> chunk_map<T, InnerMap, OuterMap, E>::combine(const chunk_map& lhs,
+                                                                                const chunk_map& rhs)
+{
+    constexpr bool keep_lhs_only = Op != set_op::overlap;
+    constexpr bool keep_rhs_only = Op == set_op::merge || Op == set_op::exclusive;
+    chunk_map out;
+    auto keep = [&](const chunk_key& key, InnerMap inner) {
+        if (!inner.empty()) out.chunks_.try_emplace(key, std::move(inner));
+    };
+    auto a = lhs.chunks_.begin();
+    auto b = rhs.chunks_.begin();
+    const auto a_end = lhs.chunks_.end();
+    const auto b_end = rhs.chunks_.end();
+    while (a != a_end && b != b_end) {
+        const auto ca = a->first.encode();
+        const auto cb = b->first.encode();
+        if (ca < cb) {
+            if constexpr (keep_lhs_only) keep(a->first, a->second);
+            ++a;
+        } else if (cb < ca) {
+            if constexpr (keep_rhs_only) keep(b->first, b->second);
+            ++b;
+        } else {
+            keep(a->first, combine_chunk<Op>(a->second, b->second));
+            ++a;
+            ++b;
+        }
+    }
+    if constexpr (keep_lhs_only)
+        for (; a != a_end; ++a) keep(a->first, a->second);
+    if constexpr (keep_rhs_only)
+        for (; b != b_end; ++b) keep(b->first, b->second);
+    return out;
+}
+
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E>
+template<set_op Op>
+void chunk_map<T, InnerMap, OuterMap, E>::combine_with(const chunk_map& rhs)
+{
+    if (this == &rhs) {
+        if constexpr (Op == set_op::subtract || Op == set_op::exclusive) clear();
+        return;
+    }
+    if constexpr (Op == set_op::overlap) {
+        for (auto it = chunks_.begin(); it != chunks_.end();) {
+            auto other = rhs.find_chunk(it->first);
+            if (other != rhs.chunks_.end()) {
+                combine_chunk_with<Op>(it->second, other->second);
+                if (!it->second.empty()) { ++it; continue; }
+            }
+            it = chunks_.erase(it);
+            cache_.clear();
+        }
+    } else {
+        for (auto const& [key, other] : rhs.chunks_) {
+            auto it = find_chunk(key);
+            if (it == chunks_.end()) {
+                if constexpr (Op == set_op::merge || Op == set_op::exclusive) {
+                    if (!other.empty()) {
+                        chunks_.try_emplace(key, other);
+                        cache_.clear();
+                    }
+                }
+                continue;
+            }
+            combine_chunk_with<Op>(it->second, other);
+            if (it->second.empty()) {
+                chunks_.erase(it);
+                cache_.clear();
+            }
+        }
+    }
+}
+
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E>
+auto chunk_map<T, InnerMap, OuterMap, E>::overlap(const chunk_map& lhs,
                                                const chunk_map& rhs)
 {
-    return views::overlap(lhs, rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::overlap(lhs, rhs, key_less{});
 }
 
-template<typename T, typename InnerMap, typename OuterMap>
-auto chunk_map<T, InnerMap, OuterMap>::overlap(const chunk_map& rhs)
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E>
+auto chunk_map<T, InnerMap, OuterMap, E>::overlap(const chunk_map& rhs)
 {
-    return views::overlap(rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::overlap(rhs, key_less{});
 }
 
-template<typename T, typename InnerMap, typename OuterMap>
-auto chunk_map<T, InnerMap, OuterMap>::subtract(const chunk_map& lhs,
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E>
+auto chunk_map<T, InnerMap, OuterMap, E>::subtract(const chunk_map& lhs,
                                                 const chunk_map& rhs)
 {
-    return views::subtract(lhs, rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::subtract(lhs, rhs, key_less{});
 }
 
-template<typename T, typename InnerMap, typename OuterMap>
-auto chunk_map<T, InnerMap, OuterMap>::subtract(const chunk_map& rhs)
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E>
+auto chunk_map<T, InnerMap, OuterMap, E>::subtract(const chunk_map& rhs)
 {
-    return views::subtract(rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::subtract(rhs, key_less{});
 }
 
-template<typename T, typename InnerMap, typename OuterMap>
-auto chunk_map<T, InnerMap, OuterMap>::merge(const chunk_map& lhs,
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E>
+auto chunk_map<T, InnerMap, OuterMap, E>::merge(const chunk_map& lhs,
                                              const chunk_map& rhs)
 {
-    return views::merge(lhs, rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::merge(lhs, rhs, key_less{});
 }
 
-template<typename T, typename InnerMap, typename OuterMap>
-auto chunk_map<T, InnerMap, OuterMap>::merge(const chunk_map& rhs)
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E>
+auto chunk_map<T, InnerMap, OuterMap, E>::merge(const chunk_map& rhs)
 {
-    return views::merge(rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::merge(rhs, key_less{});
 }
 
-template<typename T, typename InnerMap, typename OuterMap>
-auto chunk_map<T, InnerMap, OuterMap>::exclusive(const chunk_map& lhs,
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E>
+auto chunk_map<T, InnerMap, OuterMap, E>::exclusive(const chunk_map& lhs,
                                                  const chunk_map& rhs)
 {
-    return views::exclusive(lhs, rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::exclusive(lhs, rhs, key_less{});
 }
 
-template<typename T, typename InnerMap, typename OuterMap>
-auto chunk_map<T, InnerMap, OuterMap>::exclusive(const chunk_map& rhs)
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E>
+auto chunk_map<T, InnerMap, OuterMap, E>::exclusive(const chunk_map& rhs)
 {
-    return views::exclusive(rhs,
-        [](auto const& a, auto const& b) { return a.first < b.first; });
+    return views::exclusive(rhs, key_less{});
 }
 
 /// @brief Write elements present in both chunk_maps to output.
-template<typename T, typename InnerMap, typename OuterMap, typename OutIt>
-OutIt set_intersection(const chunk_map<T, InnerMap, OuterMap>& lhs,
-                       const chunk_map<T, InnerMap, OuterMap>& rhs,
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E, typename OutIt>
+OutIt set_intersection(const chunk_map<T, InnerMap, OuterMap, E>& lhs,
+                       const chunk_map<T, InnerMap, OuterMap, E>& rhs,
                        OutIt out)
 {
-    for (auto&& e : chunk_map<T, InnerMap, OuterMap>::overlap(lhs, rhs))
+    for (auto&& e : chunk_map<T, InnerMap, OuterMap, E>::overlap(lhs, rhs))
         *out++ = e;
     return out;
 }
 
 /// @brief Write elements present in lhs but not rhs to output iterator.
-template<typename T, typename InnerMap, typename OuterMap, typename OutIt>
-OutIt set_difference(const chunk_map<T, InnerMap, OuterMap>& lhs,
-                     const chunk_map<T, InnerMap, OuterMap>& rhs,
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E, typename OutIt>
+OutIt set_difference(const chunk_map<T, InnerMap, OuterMap, E>& lhs,
+                     const chunk_map<T, InnerMap, OuterMap, E>& rhs,
                      OutIt out)
 {
-    for (auto&& e : chunk_map<T, InnerMap, OuterMap>::subtract(lhs, rhs))
+    for (auto&& e : chunk_map<T, InnerMap, OuterMap, E>::subtract(lhs, rhs))
         *out++ = e;
     return out;
 }
 
 /// @brief Write all unique elements from both maps to output iterator.
-template<typename T, typename InnerMap, typename OuterMap, typename OutIt>
-OutIt set_union(const chunk_map<T, InnerMap, OuterMap>& lhs,
-                const chunk_map<T, InnerMap, OuterMap>& rhs,
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E, typename OutIt>
+OutIt set_union(const chunk_map<T, InnerMap, OuterMap, E>& lhs,
+                const chunk_map<T, InnerMap, OuterMap, E>& rhs,
                 OutIt out)
 {
-    for (auto&& e : chunk_map<T, InnerMap, OuterMap>::merge(lhs, rhs))
+    for (auto&& e : chunk_map<T, InnerMap, OuterMap, E>::merge(lhs, rhs))
         *out++ = e;
     return out;
 }
 
 /// @brief Write elements present in exactly one map to output iterator.
-template<typename T, typename InnerMap, typename OuterMap, typename OutIt>
-OutIt set_symmetric_difference(const chunk_map<T, InnerMap, OuterMap>& lhs,
-                               const chunk_map<T, InnerMap, OuterMap>& rhs,
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E, typename OutIt>
+OutIt set_symmetric_difference(const chunk_map<T, InnerMap, OuterMap, E>& lhs,
+                               const chunk_map<T, InnerMap, OuterMap, E>& rhs,
                                OutIt out)
 {
-    for (auto&& e : chunk_map<T, InnerMap, OuterMap>::exclusive(lhs, rhs))
+    for (auto&& e : chunk_map<T, InnerMap, OuterMap, E>::exclusive(lhs, rhs))
         *out++ = e;
     return out;
 }
 
 template<class>
 struct is_chunk_map : std::false_type {};
-template<typename T, typename InnerMap, typename OuterMap>
-struct is_chunk_map<chunk_map<T, InnerMap, OuterMap>> : std::true_type {};
+template<typename T, typename InnerMap, typename OuterMap, std::uint32_t E>
+struct is_chunk_map<chunk_map<T, InnerMap, OuterMap, E>> : std::true_type {};
 
 namespace std::ranges {
     /// @brief Convert a range to a chunk_map.
@@ -456,10 +1002,7 @@ namespace std::ranges {
             }
         } else {
             C out;
-            for (auto&& elem : r) {
-                auto&& [gp, val] = elem;
-                out[gp] = std::forward<decltype(val)>(val);
-            }
+            out.assign_sorted(std::forward<R>(r));
             return out;
         }
     }
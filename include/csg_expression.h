@@ -0,0 +1,242 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "chunk_map.h"
+#include "set_views.h"
+
+/**
+ * @brief Lazy CSG expressions over chunk maps.
+ *
+ * `csg::lazy(a) | b` builds an expression tree instead of a map; the
+ * operators `|`, `&`, `-` and `^` stand for merge, overlap, subtract and
+ * exclusive and combine expressions with further expressions or maps.
+ * csg::evaluate() then walks the tree once per chunk: the chunks that
+ * can be non-empty are derived from the operands' chunk sets first, and
+ * each of those is computed bottom-up with chunk_map::combine_chunk, so
+ * no intermediate map is ever built. A subtree whose result is the
+ * unchanged chunk of one operand is passed through without copying.
+ *
+ * Expressions hold pointers to their operand maps and must not outlive
+ * them; temporary maps are rejected as operands at compile time, so an
+ * eager subexpression such as `(b | c)` has to be named or made lazy.
+ * On shared keys the left operand's value wins, as in the views.
+ */
+namespace csg {
+
+    /// @brief Chunk result that either borrows an operand chunk or owns a computed one.
+    template<typename Inner>
+    class chunk_result {
+    public:
+        /// @brief Empty result.
+        chunk_result() = default;
+        /// @brief Borrow an operand chunk; nullptr means empty.
+        explicit chunk_result(const Inner* borrowed) : borrowed_(borrowed) {}
+        /// @brief Own a computed chunk.
+        explicit chunk_result(Inner&& owned) : owned_(std::move(owned)) {}
+
+        /// @brief Chunk contents or nullptr if the result holds nothing.
+        const Inner* get() const {
+            const Inner* p = owned_ ? &*owned_ : borrowed_;
+            return p && !p->empty() ? p : nullptr;
+        }
+        /// @brief True if the chunk holds no voxels.
+        bool empty() const { return get() == nullptr; }
+        /// @brief Chunk contents as an owned map, copying only borrowed chunks.
+        Inner take() && { return owned_ ? std::move(*owned_) : *borrowed_; }
+
+    private:
+        const Inner* borrowed_{nullptr}; ///< @brief Operand chunk when nothing was computed.
+        std::optional<Inner> owned_{};   ///< @brief Computed chunk.
+    };
+
+    /// @brief Expression leaf referring to a map.
+    template<typename Map>
+    class leaf {
+    public:
+        /// @brief Map type produced by evaluation.
+        using map_type = Map;
+        /// @brief Per-chunk map type.
+        using chunk_type = typename Map::chunk_type;
+
+        /// @brief Refer to map without copying it.
+        explicit leaf(const Map& map) : map_(&map) {}
+
+        /// @brief Append the positions of stored chunks in Morton order.
+        void support(std::vector<ChunkPosition>& out) const {
+            map_->for_each_chunk([&](ChunkPosition c, const chunk_type&) { out.push_back(c); });
+        }
+        /// @brief Chunk c of the map, borrowed.
+        chunk_result<chunk_type> eval(ChunkPosition c) const { return chunk_result<chunk_type>(map_->chunk(c)); }
+
+    private:
+        const Map* map_; ///< @brief Referenced map.
+    };
+
+    /// @brief Expression node applying set operation Op to two subexpressions.
+    template<set_op Op, typename L, typename R>
+    class node {
+        static_assert(std::is_same_v<typename L::map_type, typename R::map_type>,
+                      "csg operands must share one map type");
+    public:
+        /// @brief Map type produced by evaluation.
+        using map_type = typename L::map_type;
+        /// @brief Per-chunk map type.
+        using chunk_type = typename L::chunk_type;
+
+        /// @brief Combine two subexpressions.
+        node(L lhs, R rhs) : lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
+
+        /// @brief Append the positions of chunks that may be non-empty, in Morton order.
+        void support(std::vector<ChunkPosition>& out) const {
+            std::vector<ChunkPosition> a;
+            lhs_.support(a);
+            if constexpr (Op == set_op::subtract) {
+                out.insert(out.end(), a.begin(), a.end());
+                return;
+            }
+            std::vector<ChunkPosition> b;
+            rhs_.support(b);
+            if constexpr (Op == set_op::overlap)
+                std::ranges::set_intersection(a, b, std::back_inserter(out));
+            else
+                std::ranges::set_union(a, b, std::back_inserter(out));
+        }
+
+        /// @brief Result of the subtree for chunk c.
+        chunk_result<chunk_type> eval(ChunkPosition c) const {
+            auto l = lhs_.eval(c);
+            if constexpr (Op == set_op::overlap || Op == set_op::subtract)
+                if (l.empty()) return {};
+            auto r = rhs_.eval(c);
+            if (r.empty()) {
+                if constexpr (Op == set_op::overlap) return {};
+                return l;
+            }
+            if constexpr (Op == set_op::merge || Op == set_op::exclusive)
+                if (l.empty()) return r;
+            return chunk_result<chunk_type>(
+                map_type::template combine_chunk<Op>(*l.get(), *r.get()));
+        }
+
+    private:
+        L lhs_; ///< @brief Left subexpression.
+        R rhs_; ///< @brief Right subexpression.
+    };
+
+    /// @brief True for leaf and node types.
+    template<typename E> struct is_expression : std::false_type {};
+    template<typename Map> struct is_expression<leaf<Map>> : std::true_type {};
+    template<set_op Op, typename L, typename R> struct is_expression<node<Op, L, R>> : std::true_type {};
+
+    /// @brief Lazy CSG expression.
+    template<typename E>
+    concept expression = is_expression<std::remove_cvref_t<E>>::value;
+
+    /// @brief Operand accepted next to an expression: an expression or a chunk map.
+    template<typename E>
+    concept operand = expression<E> || is_chunk_map<std::remove_cvref_t<E>>::value;
+
+    /// @brief Chunk map passed as an rvalue, which a leaf would outlive.
+    template<typename E>
+    concept temporary_map = !std::is_lvalue_reference_v<E> && is_chunk_map<std::remove_cvref_t<E>>::value;
+
+    /// @brief Start an expression from a map.
+    template<typename Map>
+        requires is_chunk_map<Map>::value
+    leaf<Map> lazy(const Map& map) { return leaf<Map>(map); }
+    /// @brief Rejected: the leaf would point into a destroyed temporary.
+    template<typename Map>
+        requires is_chunk_map<Map>::value
+    void lazy(const Map&&) = delete;
+
+    /// @brief Wrap a map operand as a leaf, pass expressions through.
+    template<operand E>
+    auto as_expression(const E& e) {
+        if constexpr (expression<E>) return e;
+        else return lazy(e);
+    }
+
+    /// @brief Node of two operands at least one of which is an expression.
+    template<set_op Op, operand A, operand B>
+    auto make_node(const A& a, const B& b) {
+        using L = decltype(as_expression(a));
+        using R = decltype(as_expression(b));
+        return node<Op, L, R>(as_expression(a), as_expression(b));
+    }
+
+    /// @brief Lazy union.
+    template<operand A, operand B> requires (expression<A> || expression<B>)
+    auto operator|(const A& a, const B& b) { return make_node<set_op::merge>(a, b); }
+    /// @brief Lazy intersection.
+    template<operand A, operand B> requires (expression<A> || expression<B>)
+    auto operator&(const A& a, const B& b) { return make_node<set_op::overlap>(a, b); }
+    /// @brief Lazy difference.
+    template<operand A, operand B> requires (expression<A> || expression<B>)
+    auto operator-(const A& a, const B& b) { return make_node<set_op::subtract>(a, b); }
+    /// @brief Lazy symmetric difference.
+    template<operand A, operand B> requires (expression<A> || expression<B>)
+    auto operator^(const A& a, const B& b) { return make_node<set_op::exclusive>(a, b); }
+
+    /// @brief Rejected: a temporary map operand would dangle inside the expression.
+    template<typename A, typename B>
+        requires operand<A> && operand<B> && (expression<A> || expression<B>)
+              && (temporary_map<A> || temporary_map<B>)
+    void operator|(A&&, B&&) = delete;
+    /// @brief Rejected: a temporary map operand would dangle inside the expression.
+    template<typename A, typename B>
+        requires operand<A> && operand<B> && (expression<A> || expression<B>)
+              && (temporary_map<A> || temporary_map<B>)
+    void operator&(A&&, B&&) = delete;
+    /// @brief Rejected: a temporary map operand would dangle inside the expression.
+    template<typename A, typename B>
+        requires operand<A> && operand<B> && (expression<A> || expression<B>)
+              && (temporary_map<A> || temporary_map<B>)
+    void operator-(A&&, B&&) = delete;
+    /// @brief Rejected: a temporary map operand would dangle inside the expression.
+    template<typename A, typename B>
+        requires operand<A> && operand<B> && (expression<A> || expression<B>)
+              && (temporary_map<A> || temporary_map<B>)
+    void operator^(A&&, B&&) = delete;
+
+    /// @brief Positions of the chunks an expression may fill, in Morton order.
+    template<expression E>
+    std::vector<ChunkPosition> support(const E& e) {
+        std::vector<ChunkPosition> out;
+        e.support(out);
+        return out;
+    }
+
+    /// @brief Evaluate an expression into a new map.
+    template<expression E>
+    typename E::map_type evaluate(const E& e) {
+        typename E::map_type out;
+        for (ChunkPosition c : support(e)) {
+            auto r = e.eval(c);
+            if (!r.empty()) out.assign_chunk(c, std::move(r).take());
+        }
+        return out;
+    }
+
+    /**
+     * @brief Stream an expression's voxels to consumer in Morton order.
+     *
+     * consumer is called as consumer(GlobalPosition, const T&); chunks
+     * borrowed from an operand are read in place without copying.
+     */
+    template<expression E, typename Fn>
+    void evaluate(const E& e, Fn&& consumer) {
+        using map_type = typename E::map_type;
+        for (ChunkPosition c : support(e)) {
+            auto r = e.eval(c);
+            if (auto inner = r.get())
+                for (auto&& [lp, val] : *inner) consumer(map_type::geometry::combine(c, lp), val);
+        }
+    }
+
+} // namespace csg
@@ -7,14 +7,24 @@
 #include <concepts>
 #include <type_traits>
 #include <bitset>
+#include <array>
+#include <span>
 #include <cstdint>
+#include <climits>
+#include <limits>
+#include <algorithm>
 
-/// @brief Specialisation of flat_vector for array_packed providing contiguous storage.
-template<std::size_t N, std::integral T>
-class flat_vector<array_packed<N, T>> {
+/**
+ * @brief Specialisation of flat_vector for array_packed providing contiguous storage.
+ *
+ * Covers plain-encoded arrays of any plane storage; Storage only decides
+ * the type of the element copies handed out.
+ */
+template<std::size_t N, std::integral T, typename Storage>
+class flat_vector<array_packed<N, T, plain_encoding, Storage>> {
 public:
     /// @brief Value type stored in the container.
-    using value_type = array_packed<N, T>;
+    using value_type = array_packed<N, T, plain_encoding, Storage>;
     /// @brief Size type of the container.
     using size_type  = std::size_t;
 
@@ -32,9 +42,16 @@ public:
     /// @brief Resize container to hold n elements.
     void resize(size_type n) {
         if (n < size()) {
-            size_type remove = 0;
-            for (size_type i = n; i < elementBitCount_.size(); ++i) remove += elementBitCount_[i];
-            bits_.resize(bits_.size() - remove);
+            bits_.resize(plane_offset(n));
+            elementBitCount_.resize(n);
+            localOffset_.resize(n);
+            blockOffset_.resize((n + block - 1) / block);
+            return;
+        }
+        // New elements have no planes and start where the planes end.
+        for (size_type i = size(); i < n; ++i) {
+            if (i % block == 0) blockOffset_.push_back(bits_.size());
+            localOffset_.push_back(static_cast<std::uint16_t>(bits_.size() - blockOffset_[i / block]));
         }
         elementBitCount_.resize(n, 0);
     }
@@ -46,6 +63,66 @@ public:
     }
     /// @brief Append element to container (rvalue overload).
     void push_back(value_type&& v) { push_back(static_cast<const value_type&>(v)); }
+    /// @brief Append element given as plain values, writing each plane once.
+    void push_back(const std::array<T, N>& values) {
+        unsigned_t all = 0;
+        for (T v : values) all |= std::bit_cast<unsigned_t>(v);
+        const size_type planes = static_cast<size_type>(std::bit_width(all));
+        const size_type start = bits_.size();
+        resize(size() + 1);
+        bits_.resize(start + planes);
+        packed_bits::store_planes<T, N>(values, {bits_.data() + start, planes});
+        elementBitCount_.back() = static_cast<std::uint8_t>(planes);
+    }
+
+    /// @brief Number of bit planes of an element; 0 means all its values are zero.
+    size_type planes(size_type elem) const noexcept { return elementBitCount_[elem]; }
+
+    /// @brief Bit planes of an element, least significant first; invalidated by any modification.
+    std::span<const std::bitset<N>> bit_planes(size_type elem) const {
+        if (elementBitCount_[elem] == 0) return {};
+        return {bits_.data() + plane_offset(elem), elementBitCount_[elem]};
+    }
+
+    /// @brief All values of an element, locating its planes once.
+    std::array<T, N> unpack(size_type elem) const {
+        return packed_bits::load_planes<T, N>(bit_planes(elem));
+    }
+
+    /// @brief Lanes of an element equal to v, found with one AND per plane.
+    std::bitset<N> find_equal(size_type elem, T v) const {
+        return packed_bits::equal<std::bitset<N>>(bit_planes(elem), v);
+    }
+    /// @brief Number of lanes of an element equal to v.
+    size_type count_equal(size_type elem, T v) const { return find_equal(elem, v).count(); }
+    /// @brief Lanes of an element holding a value less than v.
+    std::bitset<N> less_than(size_type elem, T v) const {
+        return packed_bits::less<std::bitset<N>>(bit_planes(elem), v);
+    }
+
+    /// @brief Bit set of the non-zero values of an element, the OR of its planes.
+    std::bitset<N> occupancy(size_type elem) const {
+        std::bitset<N> mask;
+        if (elementBitCount_[elem] == 0) return mask;
+        const size_type start = plane_offset(elem);
+        for (size_type b = 0; b < elementBitCount_[elem]; ++b) mask |= bits_[start + b];
+        return mask;
+    }
+
+    /// @brief Overwrite all values of an element, resizing its planes to the widest value at most once.
+    void store(size_type elem, const std::array<T, N>& values) {
+        unsigned_t all = 0;
+        for (T v : values) all |= std::bit_cast<unsigned_t>(v);
+        fit_bitplanes_for_element(elem, static_cast<size_type>(std::bit_width(all)));
+        if (elementBitCount_[elem] == 0) return;
+        packed_bits::store_planes<T, N>(values, {bits_.data() + plane_offset(elem), elementBitCount_[elem]});
+    }
+
+    /// @brief Zero the values of an element selected by mask.
+    void reset(size_type elem, const std::bitset<N>& mask) {
+        const size_type start = plane_offset(elem);
+        for (size_type b = 0; b < elementBitCount_[elem]; ++b) bits_[start + b] &= ~mask;
+    }
 
     /// @brief Access element at index without bounds checking.
     reference operator[](size_type idx) { return reference(*this, idx); }
@@ -68,11 +145,26 @@ public:
 private:
     using unsigned_t = std::make_unsigned_t<T>;
 
-    /// @brief Compute starting bit-plane index for element.
+    /// @brief Elements per block of the plane offset directory.
+    static constexpr size_type block = 64;
+    static_assert((block - 1) * sizeof(unsigned_t) * CHAR_BIT <= std::numeric_limits<std::uint16_t>::max(),
+                  "offsets within a block must fit 16 bits");
+
+    /// @brief Starting bit-plane index of element; elem == size() gives the end of the planes.
     size_type plane_offset(size_type elem) const {
-        size_type off = 0;
-        for (size_type i = 0; i < elem; ++i) off += elementBitCount_[i];
-        return off;
+        if (elem == size()) return bits_.size();
+        return blockOffset_[elem / block] + localOffset_[elem];
+    }
+
+    /// @brief Record that element elem now has cnt planes, moving the offsets of later elements.
+    void set_plane_count(size_type elem, size_type cnt) {
+        const auto delta = static_cast<std::ptrdiff_t>(cnt) - static_cast<std::ptrdiff_t>(elementBitCount_[elem]);
+        elementBitCount_[elem] = static_cast<std::uint8_t>(cnt);
+        const size_type block_end = std::min(size(), (elem / block + 1) * block);
+        for (size_type i = elem + 1; i < block_end; ++i)
+            localOffset_[i] = static_cast<std::uint16_t>(localOffset_[i] + delta);
+        for (size_type b = elem / block + 1; b < blockOffset_.size(); ++b)
+            blockOffset_[b] = static_cast<size_type>(static_cast<std::ptrdiff_t>(blockOffset_[b]) + delta);
     }
 
     /// @brief Ensure the given element has at least cnt bit planes.
@@ -81,8 +173,20 @@ private:
         size_type cur   = elementBitCount_[elem];
         if (cnt > cur) {
             bits_.insert(bits_.begin() + start + cur, cnt - cur, {});
-            elementBitCount_[elem] = static_cast<std::uint8_t>(cnt);
+            set_plane_count(elem, cnt);
+        }
+    }
+
+    /// @brief Give the element exactly cnt bit planes, keeping the low ones.
+    void fit_bitplanes_for_element(size_type elem, size_type cnt) {
+        const size_type cur = elementBitCount_[elem];
+        if (cnt >= cur) {
+            ensure_bitplanes_for_element(elem, cnt);
+            return;
         }
+        const auto first = bits_.begin() + static_cast<std::ptrdiff_t>(plane_offset(elem) + cnt);
+        bits_.erase(first, first + static_cast<std::ptrdiff_t>(cur - cnt));
+        set_plane_count(elem, cnt);
     }
 
     /// @brief Set value at element and index.
@@ -108,14 +212,16 @@ private:
     }
 
     /// @brief Assign entire element from value.
-    void assign(size_type elem, const value_type& val) {
-        for (size_type i = 0; i < N; ++i) set(elem, i, val[i]);
-    }
+    void assign(size_type elem, const value_type& val) { store(elem, val.load_all()); }
 
     /// @brief Bit planes storing packed element data.
     std::vector<std::bitset<N>> bits_{};
     /// @brief Bit count of each element.
     std::vector<std::uint8_t> elementBitCount_{};
+    /// @brief Offset of each element's first plane from the first plane of its block.
+    std::vector<std::uint16_t> localOffset_{};
+    /// @brief Index of the first plane of each block of elements.
+    std::vector<size_type> blockOffset_{};
 
 public:
     /// @brief Proxy reference to mutable array element.
@@ -147,7 +253,7 @@ public:
         /// @brief Convert to value type.
         operator value_type() const {
             value_type tmp;
-            for (size_type i = 0; i < N; ++i) tmp[i] = vec_->get(index_, i);
+            tmp.store_all(vec_->unpack(index_));
             return tmp;
         }
     private:
@@ -167,7 +273,7 @@ public:
         /// @brief Convert to value type.
         operator value_type() const {
             value_type tmp;
-            for (size_type i = 0; i < N; ++i) tmp[i] = vec_->get(index_, i);
+            tmp.store_all(vec_->unpack(index_));
             return tmp;
         }
     private:
@@ -183,7 +289,7 @@ public:
         using iterator_category = std::random_access_iterator_tag;
         using iterator_concept  = std::random_access_iterator_tag;
         using difference_type   = std::ptrdiff_t;
-        using value_type        = array_packed<N, T>;
+        using value_type        = flat_vector::value_type;
         using reference         = flat_vector::reference;
         using pointer           = arrow_proxy<reference>;
 
@@ -234,7 +340,7 @@ public:
         using iterator_category = std::random_access_iterator_tag;
         using iterator_concept  = std::random_access_iterator_tag;
         using difference_type   = std::ptrdiff_t;
-        using value_type        = array_packed<N, T>;
+        using value_type        = flat_vector::value_type;
         using reference         = flat_vector::const_reference;
         using pointer           = arrow_proxy<reference>;
 
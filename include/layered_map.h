@@ -1,9 +1,22 @@
 #pragma once
 
 #include "chunk_map.h"
+#include "chunk_hash_map.h"
+#include "paged_chunk_table.h"
 #include "bucket_map.h"
 
-/// @brief chunk_map alias using bucket_map for inner storage.
-template<typename T>
-using layered_map = chunk_map<T, bucket_map<LocalPosition, T>>;
+/// @brief chunk_map alias using bucket_map for inner storage and Edge^3 chunks.
+template<typename T, std::uint32_t Edge = 32>
+using layered_map = chunk_map<T, bucket_map<LocalPosition, T>,
+                              std::map<ChunkKey, bucket_map<LocalPosition, T>>, Edge>;
 
+/// @brief layered_map variant keeping chunks in an open-addressing hash table.
+template<typename T, std::uint32_t Edge = 32>
+using hashed_layered_map = chunk_map<T, bucket_map<LocalPosition, T>,
+                                     chunk_hash_map<ChunkKey, bucket_map<LocalPosition, T>>, Edge>;
+
+/// @brief layered_map variant for bounded worlds with a directly indexed chunk table.
+template<typename T, unsigned WorldBits = 8, std::uint32_t Edge = 32>
+using paged_layered_map = chunk_map<T, bucket_map<LocalPosition, T>,
+                                    paged_chunk_table<ChunkKey, bucket_map<LocalPosition, T>, WorldBits>,
+                                    Edge>;
@@ -20,84 +20,79 @@ inline constexpr std::array<std::tuple<int,int,int>,6> cardinal_offsets{
 };
 
 /// @brief Write elements common to both layered_maps to output iterator.
-template<typename T, typename OutIt>
-OutIt set_intersection(const layered_map<T>& lhs,
-                       const layered_map<T>& rhs,
+template<typename T, std::uint32_t E, typename OutIt>
+OutIt set_intersection(const layered_map<T, E>& lhs,
+                       const layered_map<T, E>& rhs,
                        OutIt out)
 {
-    for (auto&& e : lhs | chunk_map<T, bucket_map<LocalPosition, T>>::overlap(rhs))
+    for (auto&& e : lhs | layered_map<T, E>::overlap(rhs))
         *out++ = e;
     return out;
 }
 
 /// @brief Combine voxels from both maps.
-template<typename T>
-layered_map<T> merge(const layered_map<T>& lhs, const layered_map<T>& rhs)
+template<typename T, std::uint32_t E>
+layered_map<T, E> merge(const layered_map<T, E>& lhs, const layered_map<T, E>& rhs)
 {
-    auto view = chunk_map<T, bucket_map<LocalPosition, T>>::merge(lhs, rhs);
-    return std::ranges::to<layered_map<T>>(view);
+    return layered_map<T, E>::template combine<set_op::merge>(lhs, rhs);
 }
 
 /// @brief Voxels present in both maps.
-template<typename T>
-layered_map<T> overlap(layered_map<T> const& lhs, layered_map<T> const& rhs)
+template<typename T, std::uint32_t E>
+layered_map<T, E> overlap(layered_map<T, E> const& lhs, layered_map<T, E> const& rhs)
 {
-    layered_map<T> out;
-    for (auto&& e : lhs | chunk_map<T, bucket_map<LocalPosition, T>>::overlap(rhs))
-        out.insert(e);
-    return out;
+    return layered_map<T, E>::template combine<set_op::overlap>(lhs, rhs);
 }
 
 /// @brief Remove rhs voxels from lhs.
-template<typename T>
-layered_map<T> subtract(const layered_map<T>& lhs, const layered_map<T>& rhs)
+template<typename T, std::uint32_t E>
+layered_map<T, E> subtract(const layered_map<T, E>& lhs, const layered_map<T, E>& rhs)
 {
-    auto view = chunk_map<T, bucket_map<LocalPosition, T>>::subtract(lhs, rhs);
-    return std::ranges::to<layered_map<T>>(view);
+    return layered_map<T, E>::template combine<set_op::subtract>(lhs, rhs);
 }
 
 /// @brief Union operator shorthand.
-template<typename T>
-layered_map<T> operator|(const layered_map<T>& lhs, const layered_map<T>& rhs)
+template<typename T, std::uint32_t E>
+layered_map<T, E> operator|(const layered_map<T, E>& lhs, const layered_map<T, E>& rhs)
 {
     return merge(lhs, rhs);
 }
 
-/// @brief In-place union assignment.
-template<typename T>
-layered_map<T>& operator|=(layered_map<T>& lhs, const layered_map<T>& rhs)
+/// @brief In-place union touching only the chunks of rhs.
+template<typename T, std::uint32_t E>
+layered_map<T, E>& operator|=(layered_map<T, E>& lhs, const layered_map<T, E>& rhs)
 {
-    lhs = merge(lhs, rhs);
+    lhs.template combine_with<set_op::merge>(rhs);
     return lhs;
 }
 
 /// @brief Intersection operator shorthand.
-template<typename T>
-layered_map<T> operator&(const layered_map<T>& lhs, const layered_map<T>& rhs)
+template<typename T, std::uint32_t E>
+layered_map<T, E> operator&(const layered_map<T, E>& lhs, const layered_map<T, E>& rhs)
 {
     return overlap(lhs, rhs);
 }
 
-/// @brief In-place intersection assignment.
-template<typename T>
-layered_map<T>& operator&=(layered_map<T>& lhs, const layered_map<T>& rhs)
+/// @brief In-place intersection dropping chunks missing from rhs.
+template<typename T, std::uint32_t E>
+layered_map<T, E>& operator&=(layered_map<T, E>& lhs, const layered_map<T, E>& rhs)
 {
-    lhs = overlap(lhs, rhs);
+    lhs.template combine_with<set_op::overlap>(rhs);
     return lhs;
 }
 
 /// @brief Difference operator shorthand.
-template<typename T>
-layered_map<T> operator-(const layered_map<T>& lhs, const layered_map<T>& rhs)
+template<typename T, std::uint32_t E>
+layered_map<T, E> operator-(const layered_map<T, E>& lhs, const layered_map<T, E>& rhs)
 {
     return subtract(lhs, rhs);
 }
 
-/// @brief In-place difference assignment.
-template<typename T>
-layered_map<T>& operator-=(layered_map<T>& lhs, const layered_map<T>& rhs)
+/// @brief In-place difference touching only the chunks of rhs.
+template<typename T, std::uint32_t E>
+layered_map<T, E>& operator-=(layered_map<T, E>& lhs, const layered_map<T, E>& rhs)
 {
-    lhs = subtract(lhs, rhs);
+    lhs.template combine_with<set_op::subtract>(rhs);
     return lhs;
 }
 
@@ -119,46 +114,42 @@ inline bool offset(GlobalPosition p, int dx, int dy, int dz, GlobalPosition& out
 }
 
 /// @brief Extrude voxels by one unit in all six cardinal directions.
-template<typename T>
-layered_map<T> extrude(layered_map<T> const& map)
+template<typename T, std::uint32_t E>
+layered_map<T, E> extrude(layered_map<T, E> const& map)
 {
-    layered_map<T> out = map;
+    layered_map<T, E> out = map;
+    auto near = out.neighbourhood();
     for (auto it = map.cbegin(); it != map.cend(); ++it) {
         auto const& [gp, val] = *it;
+        near.recentre(layered_map<T, E>::chunk_of(gp));
         for (auto [dx, dy, dz] : cardinal_offsets) {
             GlobalPosition n;
-            if (offset(gp, dx, dy, dz, n)) out[n] = val;
+            if (offset(gp, dx, dy, dz, n)) near[n] = val;
         }
     }
     return out;
 }
 
 /// @brief Remove boundary voxels leaving the interior.
-template<typename T>
-layered_map<T> inset(layered_map<T> const& map)
+template<typename T, std::uint32_t E>
+layered_map<T, E> inset(layered_map<T, E> const& map)
 {
-    layered_map<T> out;
+    layered_map<T, E> out;
+    auto near = map.neighbourhood();
     for (auto it = map.cbegin(); it != map.cend(); ++it) {
         auto const& [gp, val] = *it;
-        bool all_neighbors = true;
-        for (auto [dx, dy, dz] : cardinal_offsets) {
-            GlobalPosition n;
-            if (!offset(gp, dx, dy, dz, n) || map.find(n) == map.cend()) {
-                all_neighbors = false;
-                break;
-            }
-        }
-        if (all_neighbors) out[gp] = val;
+        near.recentre(layered_map<T, E>::chunk_of(gp));
+        if (near.has_all_neighbours6(gp)) out[gp] = val;
     }
     return out;
 }
 
 /// @brief Find the innermost core of a voxel map.
-template<typename T>
-layered_map<T> detect_core(layered_map<T> const& map)
+template<typename T, std::uint32_t E>
+layered_map<T, E> detect_core(layered_map<T, E> const& map)
 {
-    layered_map<T> prev = map;
-    layered_map<T> cur  = map;
+    layered_map<T, E> prev = map;
+    layered_map<T, E> cur  = map;
     while (!cur.empty()) {
         prev = cur;
         cur  = inset(cur);
@@ -167,15 +158,15 @@ layered_map<T> detect_core(layered_map<T> const& map)
 }
 
 /// @brief Grow a convex layer from a core within the remaining voxels.
-template<typename T>
-layered_map<T> expand_convex(layered_map<T> const& core,
-                             layered_map<T> const& remaining)
+template<typename T, std::uint32_t E>
+layered_map<T, E> expand_convex(layered_map<T, E> const& core,
+                             layered_map<T, E> const& remaining)
 {
-    layered_map<T> hull = core;
-    layered_map<T> front = core;
+    layered_map<T, E> hull = core;
+    layered_map<T, E> front = core;
     while (true) {
         front = extrude(front);
-        layered_map<T> added;
+        layered_map<T, E> added;
         for (auto const& [gp, v] : front) {
             auto it = remaining.find(gp);
             if (it != remaining.cend()) added.insert({gp, it->second});
@@ -189,12 +180,12 @@ layered_map<T> expand_convex(layered_map<T> const& core,
 }
 
 /// @brief Core-Expanding Convex Decomposition producing layered hulls.
-template<typename T>
-std::vector<layered_map<T>> core_expanding_convex_decomposition(
-    layered_map<T> const& voxels)
+template<typename T, std::uint32_t E>
+std::vector<layered_map<T, E>> core_expanding_convex_decomposition(
+    layered_map<T, E> const& voxels)
 {
-    layered_map<T> remaining = voxels;
-    std::vector<layered_map<T>> layers;
+    layered_map<T, E> remaining = voxels;
+    std::vector<layered_map<T, E>> layers;
     while (!remaining.empty()) {
         auto core = detect_core(remaining);
         if (core.empty()) {
@@ -203,7 +194,7 @@ std::vector<layered_map<T>> core_expanding_convex_decomposition(
         auto hull = expand_convex(core, remaining);
         if (hull.empty()) break;
         layers.push_back(hull);
-        layered_map<T> next;
+        layered_map<T, E> next;
         for (auto it = remaining.cbegin(); it != remaining.cend(); ++it)
             if (hull.find(it->first) == hull.end())
                 next.insert({it->first, it->second});
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+
+#if !defined(MORTON_NO_BMI2) && (defined(__x86_64__) || defined(_M_X64))
+#include <immintrin.h>
+#if defined(__BMI2__)
+#define MORTON_BMI2_STATIC 1
+#elif defined(__GNUC__) || defined(__clang__)
+#define MORTON_BMI2_DISPATCH 1
+#endif
+#endif
+
+/**
+ * @brief Morton (Z-order) encode/decode kernels.
+ *
+ * Every kernel is branch free and constant time. The magic-bits versions
+ * are constexpr and portable; the BMI2 versions use pdep/pext and are
+ * selected at compile time when building with BMI2 enabled, or at run
+ * time through CPU detection otherwise. Define MORTON_NO_BMI2 to always
+ * use the magic-bits path (pdep/pext are microcoded on AMD before Zen 3).
+ */
+namespace morton {
+
+/// @brief Spread the low 10 bits of v so they occupy every third bit.
+constexpr std::uint32_t spread3_32(std::uint32_t v)
+{
+    v &= 0x000003ffu;
+    v = (v | (v << 16)) & 0x030000ffu;
+    v = (v | (v << 8))  & 0x0300f00fu;
+    v = (v | (v << 4))  & 0x030c30c3u;
+    v = (v | (v << 2))  & 0x09249249u;
+    return v;
+}
+
+/// @brief Gather every third bit of v into the low 10 bits.
+constexpr std::uint32_t compact3_32(std::uint32_t v)
+{
+    v &= 0x09249249u;
+    v = (v | (v >> 2))  & 0x030c30c3u;
+    v = (v | (v >> 4))  & 0x0300f00fu;
+    v = (v | (v >> 8))  & 0x030000ffu;
+    v = (v | (v >> 16)) & 0x000003ffu;
+    return v;
+}
+
+/// @brief Spread the low 21 bits of v so they occupy every third bit.
+constexpr std::uint64_t spread3_64(std::uint32_t v)
+{
+    std::uint64_t x = v & 0x1fffffu;
+    x = (x | (x << 32)) & 0x001f00000000ffffull;
+    x = (x | (x << 16)) & 0x001f0000ff0000ffull;
+    x = (x | (x << 8))  & 0x100f00f00f00f00full;
+    x = (x | (x << 4))  & 0x10c30c30c30c30c3ull;
+    x = (x | (x << 2))  & 0x1249249249249249ull;
+    return x;
+}
+
+/// @brief Gather every third bit of v into the low 21 bits.
+constexpr std::uint32_t compact3_64(std::uint64_t x)
+{
+    x &= 0x1249249249249249ull;
+    x = (x | (x >> 2))  & 0x10c30c30c30c30c3ull;
+    x = (x | (x >> 4))  & 0x100f00f00f00f00full;
+    x = (x | (x >> 8))  & 0x001f0000ff0000ffull;
+    x = (x | (x >> 16)) & 0x001f00000000ffffull;
+    x = (x | (x >> 32)) & 0x00000000001fffffull;
+    return static_cast<std::uint32_t>(x);
+}
+
+/// @brief Magic-bits encode of three 10-bit coordinates.
+constexpr std::uint32_t encode32_magic(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+    return spread3_32(x) | (spread3_32(y) << 1) | (spread3_32(z) << 2);
+}
+
+/// @brief Magic-bits decode of a 30-bit code.
+constexpr std::array<std::uint32_t, 3> decode32_magic(std::uint32_t code)
+{
+    return {compact3_32(code), compact3_32(code >> 1), compact3_32(code >> 2)};
+}
+
+/// @brief Magic-bits encode of three 21-bit coordinates.
+constexpr std::uint64_t encode64_magic(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+    return spread3_64(x) | (spread3_64(y) << 1) | (spread3_64(z) << 2);
+}
+
+/// @brief Magic-bits decode of a 63-bit code.
+constexpr std::array<std::uint32_t, 3> decode64_magic(std::uint64_t code)
+{
+    return {compact3_64(code), compact3_64(code >> 1), compact3_64(code >> 2)};
+}
+
+/// @brief Bit masks selecting the x, y and z lanes of a 64-bit code.
+inline constexpr std::uint64_t lane_x = 0x1249249249249249ull;
+inline constexpr std::uint64_t lane_y = lane_x << 1;
+inline constexpr std::uint64_t lane_z = lane_x << 2;
+
+#if defined(MORTON_BMI2_STATIC) || defined(MORTON_BMI2_DISPATCH)
+#if defined(MORTON_BMI2_DISPATCH)
+#define MORTON_BMI2_TARGET __attribute__((target("bmi2")))
+#else
+#define MORTON_BMI2_TARGET
+#endif
+
+/// @brief pdep encode of three 21-bit coordinates. Requires BMI2.
+MORTON_BMI2_TARGET inline std::uint64_t encode64_bmi2(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+    return _pdep_u64(x, lane_x) | _pdep_u64(y, lane_y) | _pdep_u64(z, lane_z);
+}
+
+/// @brief pext decode of a 63-bit code. Requires BMI2.
+MORTON_BMI2_TARGET inline std::array<std::uint32_t, 3> decode64_bmi2(std::uint64_t code)
+{
+    return {static_cast<std::uint32_t>(_pext_u64(code, lane_x)),
+            static_cast<std::uint32_t>(_pext_u64(code, lane_y)),
+            static_cast<std::uint32_t>(_pext_u64(code, lane_z))};
+}
+
+#undef MORTON_BMI2_TARGET
+#endif
+
+#if defined(MORTON_BMI2_STATIC)
+/// @brief True when the BMI2 kernels may be called.
+inline constexpr bool bmi2_available = true;
+#elif defined(MORTON_BMI2_DISPATCH)
+/// @brief Query the CPU for BMI2 support.
+inline bool detect_bmi2() noexcept
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+}
+/// @brief True when the BMI2 kernels may be called.
+inline const bool bmi2_available = detect_bmi2();
+#else
+/// @brief True when the BMI2 kernels may be called.
+inline constexpr bool bmi2_available = false;
+#endif
+
+/// @brief Spread table for 6-bit local coordinates.
+inline constexpr auto local_spread = [] {
+    std::array<std::uint32_t, 64> t{};
+    for (std::uint32_t i = 0; i < 64; ++i)
+        t[i] = spread3_32(i);
+    return t;
+}();
+
+/// @brief Coordinates packed as x | y << 3 | z << 6 for each 9-bit code.
+inline constexpr auto local_compact = [] {
+    std::array<std::uint16_t, 512> t{};
+    for (std::uint32_t c = 0; c < 512; ++c) {
+        auto [x, y, z] = decode32_magic(c);
+        t[c] = static_cast<std::uint16_t>(x | (y << 3) | (z << 6));
+    }
+    return t;
+}();
+
+/// @brief Table encode of coordinates inside a chunk of edge up to 64.
+constexpr std::uint32_t encode_local(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+    return local_spread[x & 63] | (local_spread[y & 63] << 1) | (local_spread[z & 63] << 2);
+}
+
+/// @brief Table decode of an 18-bit code inside a chunk of edge up to 64.
+constexpr std::array<std::uint32_t, 3> decode_local(std::uint32_t code)
+{
+    std::uint32_t lo = local_compact[code & 511];
+    std::uint32_t hi = local_compact[(code >> 9) & 511];
+    return {(lo & 7) | ((hi & 7) << 3),
+            ((lo >> 3) & 7) | (((hi >> 3) & 7) << 3),
+            ((lo >> 6) & 7) | (((hi >> 6) & 7) << 3)};
+}
+
+} // namespace morton
+
+/// @brief Morton encode three 10-bit coordinates.
+constexpr std::uint32_t morton_encode(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+    return morton::encode32_magic(x, y, z);
+}
+
+/// @brief Decode Morton code into coordinates.
+constexpr std::array<std::uint32_t, 3> morton_decode(std::uint32_t code)
+{
+    return morton::decode32_magic(code);
+}
+
+/// @brief Morton encode three 21-bit coordinates into a 64-bit code.
+constexpr std::uint64_t morton_encode64(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+    if !consteval {
+#if defined(MORTON_BMI2_STATIC)
+        return morton::encode64_bmi2(x, y, z);
+#elif defined(MORTON_BMI2_DISPATCH)
+        if (morton::bmi2_available) return morton::encode64_bmi2(x, y, z);
+#endif
+    }
+    return morton::encode64_magic(x, y, z);
+}
+
+/// @brief Decode 64-bit Morton code into coordinates.
+constexpr std::array<std::uint32_t, 3> morton_decode64(std::uint64_t code)
+{
+    if !consteval {
+#if defined(MORTON_BMI2_STATIC)
+        return morton::decode64_bmi2(code);
+#elif defined(MORTON_BMI2_DISPATCH)
+        if (morton::bmi2_available) return morton::decode64_bmi2(code);
+#endif
+    }
+    return morton::decode64_magic(code);
+}
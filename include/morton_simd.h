@@ -0,0 +1,147 @@
+#pragma once
+
+#include <experimental/simd>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include "positions.h"
+
+/**
+ * @brief Batch Morton encode/decode over spans of positions.
+ *
+ * Coordinates are processed a native SIMD register at a time using the
+ * same magic-bits sequence as the scalar kernels in morton.h; the tail
+ * that does not fill a register falls back to the scalar kernels.
+ */
+namespace morton {
+
+/// @brief SIMD register type used by the batch kernels.
+using batch_simd = std::experimental::native_simd<std::uint64_t>;
+
+/// @brief Lane-wise spread of the low 21 bits to every third bit.
+template<typename V>
+V spread3_64_simd(V x)
+{
+    x &= V(0x1fffffull);
+    x = (x | (x << 32)) & V(0x001f00000000ffffull);
+    x = (x | (x << 16)) & V(0x001f0000ff0000ffull);
+    x = (x | (x << 8))  & V(0x100f00f00f00f00full);
+    x = (x | (x << 4))  & V(0x10c30c30c30c30c3ull);
+    x = (x | (x << 2))  & V(0x1249249249249249ull);
+    return x;
+}
+
+/// @brief Lane-wise gather of every third bit into the low 21 bits.
+template<typename V>
+V compact3_64_simd(V x)
+{
+    x &= V(0x1249249249249249ull);
+    x = (x | (x >> 2))  & V(0x10c30c30c30c30c3ull);
+    x = (x | (x >> 4))  & V(0x100f00f00f00f00full);
+    x = (x | (x >> 8))  & V(0x001f0000ff0000ffull);
+    x = (x | (x >> 16)) & V(0x001f00000000ffffull);
+    x = (x | (x >> 32)) & V(0x00000000001fffffull);
+    return x;
+}
+
+} // namespace morton
+
+/// @brief Encode structure-of-arrays coordinate columns into Morton codes.
+inline void morton_encode_batch(std::span<const std::uint32_t> xs,
+                                std::span<const std::uint32_t> ys,
+                                std::span<const std::uint32_t> zs,
+                                std::span<std::uint64_t> out)
+{
+    using V = morton::batch_simd;
+    constexpr std::size_t W = V::size();
+    const std::size_t n = xs.size();
+    assert(ys.size() >= n && zs.size() >= n && out.size() >= n);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V x([&](auto l) { return std::uint64_t(xs[i + l]); });
+        V y([&](auto l) { return std::uint64_t(ys[i + l]); });
+        V z([&](auto l) { return std::uint64_t(zs[i + l]); });
+        V code = morton::spread3_64_simd(x)
+               | (morton::spread3_64_simd(y) << 1)
+               | (morton::spread3_64_simd(z) << 2);
+        code.copy_to(out.data() + i, std::experimental::element_aligned);
+    }
+    for (; i < n; ++i) out[i] = morton::encode64_magic(xs[i], ys[i], zs[i]);
+}
+
+/// @brief Encode an array of positions into Morton codes.
+inline void morton_encode_batch(std::span<const GlobalPosition> in,
+                                std::span<std::uint64_t> out)
+{
+    using V = morton::batch_simd;
+    constexpr std::size_t W = V::size();
+    const std::size_t n = in.size();
+    assert(out.size() >= n);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V x([&](auto l) { return std::uint64_t(in[i + l].x); });
+        V y([&](auto l) { return std::uint64_t(in[i + l].y); });
+        V z([&](auto l) { return std::uint64_t(in[i + l].z); });
+        V code = morton::spread3_64_simd(x)
+               | (morton::spread3_64_simd(y) << 1)
+               | (morton::spread3_64_simd(z) << 2);
+        code.copy_to(out.data() + i, std::experimental::element_aligned);
+    }
+    for (; i < n; ++i) out[i] = morton::encode64_magic(in[i].x, in[i].y, in[i].z);
+}
+
+/// @brief Decode Morton codes into structure-of-arrays coordinate columns.
+inline void morton_decode_batch(std::span<const std::uint64_t> in,
+                                std::span<std::uint32_t> xs,
+                                std::span<std::uint32_t> ys,
+                                std::span<std::uint32_t> zs)
+{
+    using V = morton::batch_simd;
+    constexpr std::size_t W = V::size();
+    const std::size_t n = in.size();
+    assert(xs.size() >= n && ys.size() >= n && zs.size() >= n);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V code(in.data() + i, std::experimental::element_aligned);
+        V x = morton::compact3_64_simd(code);
+        V y = morton::compact3_64_simd(code >> 1);
+        V z = morton::compact3_64_simd(code >> 2);
+        for (std::size_t l = 0; l < W; ++l) {
+            xs[i + l] = static_cast<std::uint32_t>(x[l]);
+            ys[i + l] = static_cast<std::uint32_t>(y[l]);
+            zs[i + l] = static_cast<std::uint32_t>(z[l]);
+        }
+    }
+    for (; i < n; ++i) {
+        auto p = morton::decode64_magic(in[i]);
+        xs[i] = p[0];
+        ys[i] = p[1];
+        zs[i] = p[2];
+    }
+}
+
+/// @brief Decode Morton codes into an array of positions.
+inline void morton_decode_batch(std::span<const std::uint64_t> in,
+                                std::span<GlobalPosition> out)
+{
+    using V = morton::batch_simd;
+    constexpr std::size_t W = V::size();
+    const std::size_t n = in.size();
+    assert(out.size() >= n);
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        V code(in.data() + i, std::experimental::element_aligned);
+        V x = morton::compact3_64_simd(code);
+        V y = morton::compact3_64_simd(code >> 1);
+        V z = morton::compact3_64_simd(code >> 2);
+        for (std::size_t l = 0; l < W; ++l)
+            out[i + l] = GlobalPosition{static_cast<std::uint32_t>(x[l]),
+                                        static_cast<std::uint32_t>(y[l]),
+                                        static_cast<std::uint32_t>(z[l])};
+    }
+    for (; i < n; ++i) {
+        auto p = morton::decode64_magic(in[i]);
+        out[i] = GlobalPosition{p[0], p[1], p[2]};
+    }
+}
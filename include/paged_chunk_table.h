@@ -0,0 +1,367 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <tuple>
+#include <iterator>
+#include <stdexcept>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "morton.h"
+
+/**
+ * @brief Direct indexed chunk table for worlds with known bounds.
+ *
+ * Designed as a drop in `OuterMap` for chunk_map when every chunk
+ * coordinate is below `2^WorldBits`. The Morton code of a chunk is used
+ * directly as its index: the high bits select a page in a directory and
+ * the low `PageBits` bits select a slot inside it, so a lookup is two
+ * loads. The directory is allocated on first insert, pages on the first
+ * insert into them; a page is released when its last entry is erased.
+ *
+ * Walking the directory and the slots in index order visits keys in
+ * Morton order, matching the ordering of std::map keyed by ChunkKey.
+ * Keys must be constructible from ChunkPosition and expose `encode()`.
+ * Lookups outside the bounds miss; inserting outside them throws
+ * std::out_of_range. Erasing an entry invalidates only iterators to it.
+ */
+template<typename Key, typename T, unsigned WorldBits = 8, unsigned PageBits = 9>
+class paged_chunk_table {
+    static_assert(WorldBits >= 1 && WorldBits <= 12, "WorldBits must be in [1, 12]");
+    static_assert(PageBits >= 6 && PageBits <= 3 * WorldBits, "PageBits must be in [6, 3 * WorldBits]");
+    static_assert(PageBits <= 16, "pages must hold at most 2^16 slots");
+    static_assert(3 * WorldBits <= PageBits + 20, "directory must hold at most 2^20 pages");
+public:
+    /// @brief Key type used for lookup.
+    using key_type    = Key;
+    /// @brief Value type stored per key.
+    using mapped_type = T;
+    /// @brief Key/value pair stored in each slot.
+    using value_type  = std::pair<const Key, T>;
+    /// @brief Size type of the container.
+    using size_type   = std::size_t;
+
+    /// @brief Number of chunk codes addressable by the table.
+    static constexpr std::uint64_t code_limit = std::uint64_t{1} << (3 * WorldBits);
+    /// @brief Number of slots held by one page.
+    static constexpr size_type page_size = size_type{1} << PageBits;
+    /// @brief Number of pages in the directory.
+    static constexpr size_type page_count = static_cast<size_type>(code_limit >> PageBits);
+
+    class iterator;
+    class const_iterator;
+
+    /// @brief Construct empty table without allocating.
+    paged_chunk_table() = default;
+
+    /// @brief Copy every allocated page.
+    paged_chunk_table(const paged_chunk_table& other) {
+        if (!other.pages_.empty()) allocate_directory();
+        for (size_type p = 0; p < other.pages_.size(); ++p) {
+            if (!other.pages_[p]) continue;
+            pages_[p] = std::make_unique<page>(*other.pages_[p]);
+            page_mask_[p / 64] |= std::uint64_t{1} << (p % 64);
+        }
+        size_ = other.size_;
+    }
+    /// @brief Move construct by taking the directory, leaving other empty.
+    paged_chunk_table(paged_chunk_table&& other) noexcept
+        : pages_(std::move(other.pages_)), page_mask_(std::move(other.page_mask_)),
+          size_(std::exchange(other.size_, 0)) {}
+    /// @brief Copy assign through copy and swap.
+    paged_chunk_table& operator=(const paged_chunk_table& other) {
+        if (this != &other) *this = paged_chunk_table(other);
+        return *this;
+    }
+    /// @brief Move assign by taking the directory, leaving other empty.
+    paged_chunk_table& operator=(paged_chunk_table&& other) noexcept {
+        pages_ = std::move(other.pages_);
+        page_mask_ = std::move(other.page_mask_);
+        size_ = std::exchange(other.size_, 0);
+        return *this;
+    }
+
+    /// @brief True if no keys are stored.
+    bool empty() const noexcept { return size_ == 0; }
+    /// @brief Number of stored keys.
+    size_type size() const noexcept { return size_; }
+
+    /// @brief Remove all keys and release every page.
+    void clear() noexcept {
+        for (auto& p : pages_) p.reset();
+        std::ranges::fill(page_mask_, 0);
+        size_ = 0;
+    }
+
+    /// @brief True if key lies inside the table bounds.
+    static constexpr bool in_bounds(const Key& key) noexcept {
+        return static_cast<std::uint64_t>(key.encode()) < code_limit;
+    }
+
+    /// @brief Iterator to key or end().
+    iterator find(const Key& key) { return iterator(this, find_index(key)); }
+    /// @brief Const iterator to key or end().
+    const_iterator find(const Key& key) const { return const_iterator(this, find_index(key)); }
+    /// @brief True if key is stored.
+    bool contains(const Key& key) const { return find_index(key) != npos; }
+    /// @brief Iterator to the first key whose Morton code is not below key's, or end().
+    iterator lower_bound(const Key& key) { return iterator(this, lower_bound_index(key)); }
+    /// @brief Const iterator to the first key whose Morton code is not below key's, or end().
+    const_iterator lower_bound(const Key& key) const { return const_iterator(this, lower_bound_index(key)); }
+
+    /**
+     * @brief Insert value constructed from args if key is missing.
+     *
+     * A page needed for the key is published only once the value is
+     * constructed, so a throwing constructor leaves the table unchanged.
+     */
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        const std::uint64_t code = static_cast<std::uint64_t>(key.encode());
+        if (code >= code_limit) throw std::out_of_range("paged_chunk_table::try_emplace");
+        const size_type p = static_cast<size_type>(code >> PageBits);
+        const size_type s = static_cast<size_type>(code) & (page_size - 1);
+        if (pages_.empty()) allocate_directory();
+        std::unique_ptr<page> fresh;
+        page* pg = pages_[p].get();
+        if (!pg) {
+            fresh = std::make_unique<page>();
+            pg = fresh.get();
+        } else if (pg->slots[s]) {
+            return {iterator(this, static_cast<size_type>(code)), false};
+        }
+        pg->slots[s].emplace(std::piecewise_construct,
+                             std::forward_as_tuple(key),
+                             std::forward_as_tuple(std::forward<Args>(args)...));
+        if (fresh) {
+            pages_[p] = std::move(fresh);
+            page_mask_[p / 64] |= std::uint64_t{1} << (p % 64);
+        }
+        pg->mask[s / 64] |= std::uint64_t{1} << (s % 64);
+        ++pg->count;
+        ++size_;
+        return {iterator(this, static_cast<size_type>(code)), true};
+    }
+
+    /// @brief Access value, inserting a default one if missing.
+    T& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+    /// @brief Access existing value or throw std::out_of_range.
+    T& at(const Key& key) {
+        auto i = find_index(key);
+        if (i == npos) throw std::out_of_range("paged_chunk_table::at");
+        return slot(i)->second;
+    }
+    /// @brief Access existing value or throw std::out_of_range (const).
+    const T& at(const Key& key) const {
+        auto i = find_index(key);
+        if (i == npos) throw std::out_of_range("paged_chunk_table::at");
+        return slot(i)->second;
+    }
+
+    /// @brief Erase key and return count removed.
+    size_type erase(const Key& key) {
+        auto i = find_index(key);
+        if (i == npos) return 0;
+        erase_index(i);
+        return 1;
+    }
+
+    /// @brief Erase entry and return iterator to the next one in Morton order.
+    iterator erase(const_iterator pos) {
+        size_type next = next_index(pos.index_);
+        erase_index(pos.index_);
+        return iterator(this, next);
+    }
+
+    /// @brief Iterator to the entry with the smallest Morton code.
+    iterator begin() { return iterator(this, first_index()); }
+    /// @brief Iterator past the last entry.
+    iterator end() noexcept { return iterator(this, npos); }
+    /// @brief Const iterator to the entry with the smallest Morton code.
+    const_iterator begin() const { return cbegin(); }
+    /// @brief Const iterator past the last entry.
+    const_iterator end() const noexcept { return cend(); }
+    /// @brief Const iterator to the entry with the smallest Morton code.
+    const_iterator cbegin() const { return const_iterator(this, first_index()); }
+    /// @brief Const iterator past the last entry.
+    const_iterator cend() const noexcept { return const_iterator(this, npos); }
+
+    /// @brief Forward iterator over mutable entries in Morton order.
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using iterator_concept  = std::forward_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = paged_chunk_table::value_type;
+        using reference         = value_type&;
+        using pointer           = value_type*;
+
+        /// @brief Default constructed iterator.
+        iterator() = default;
+        /// @brief Construct from parent and Morton index.
+        iterator(paged_chunk_table* t, size_type index) : table_(t), index_(index) {}
+
+        /// @brief Dereference to stored pair.
+        reference operator*() const { return *table_->slot(index_); }
+        /// @brief Member access to stored pair.
+        pointer operator->() const { return &*table_->slot(index_); }
+        /// @brief Advance to the next key in Morton order.
+        iterator& operator++() { index_ = table_->next_index(index_); return *this; }
+        /// @brief Post-increment iterator.
+        iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+        /// @brief Equality comparison.
+        bool operator==(const iterator& o) const { return index_ == o.index_; }
+
+    private:
+        paged_chunk_table* table_{}; ///< @brief Parent container pointer.
+        size_type index_{npos};      ///< @brief Current Morton index or npos at end.
+        friend class paged_chunk_table;
+        friend class const_iterator;
+    };
+
+    /// @brief Forward iterator over constant entries in Morton order.
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using iterator_concept  = std::forward_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = paged_chunk_table::value_type;
+        using reference         = const value_type&;
+        using pointer           = const value_type*;
+
+        /// @brief Default constructed iterator.
+        const_iterator() = default;
+        /// @brief Construct from parent and Morton index.
+        const_iterator(const paged_chunk_table* t, size_type index) : table_(t), index_(index) {}
+        /// @brief Convert from mutable iterator.
+        const_iterator(iterator it) : table_(it.table_), index_(it.index_) {}
+
+        /// @brief Dereference to stored pair.
+        reference operator*() const { return *table_->slot(index_); }
+        /// @brief Member access to stored pair.
+        pointer operator->() const { return &*table_->slot(index_); }
+        /// @brief Advance to the next key in Morton order.
+        const_iterator& operator++() { index_ = table_->next_index(index_); return *this; }
+        /// @brief Post-increment iterator.
+        const_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+        /// @brief Equality comparison.
+        bool operator==(const const_iterator& o) const { return index_ == o.index_; }
+
+    private:
+        const paged_chunk_table* table_{}; ///< @brief Parent container pointer.
+        size_type index_{npos};            ///< @brief Current Morton index or npos at end.
+        friend class paged_chunk_table;
+    };
+
+private:
+    /// @brief Index used for end iterators and failed lookups.
+    static constexpr size_type npos = static_cast<size_type>(-1);
+    /// @brief Number of 64-bit words in a page occupancy mask.
+    static constexpr size_type mask_words = (page_size + 63) / 64;
+
+    /// @brief Slots of one page plus occupancy bits for fast skipping.
+    struct page {
+        /// @brief In-place stored entries.
+        std::array<std::optional<value_type>, page_size> slots{};
+        /// @brief Bit set for each occupied slot.
+        std::array<std::uint64_t, mask_words> mask{};
+        /// @brief Number of occupied slots.
+        size_type count{0};
+    };
+
+    /// @brief Stored entry at Morton index i.
+    std::optional<value_type>& slot(size_type i) {
+        return pages_[i >> PageBits]->slots[i & (page_size - 1)];
+    }
+    /// @brief Stored entry at Morton index i (const).
+    const std::optional<value_type>& slot(size_type i) const {
+        return pages_[i >> PageBits]->slots[i & (page_size - 1)];
+    }
+
+    /// @brief Allocate the empty page directory; the page list goes last as it marks the directory live.
+    void allocate_directory() {
+        page_mask_.resize((page_count + 63) / 64);
+        pages_.resize(page_count);
+    }
+
+    /// @brief Morton index of key or npos.
+    size_type find_index(const Key& key) const {
+        const std::uint64_t code = static_cast<std::uint64_t>(key.encode());
+        if (code >= code_limit || size_ == 0) return npos;
+        const page* pg = pages_[static_cast<size_type>(code >> PageBits)].get();
+        if (!pg || !pg->slots[static_cast<size_type>(code) & (page_size - 1)]) return npos;
+        return static_cast<size_type>(code);
+    }
+
+    /// @brief Destroy entry at Morton index i and release its page if empty.
+    void erase_index(size_type i) {
+        const size_type p = i >> PageBits;
+        const size_type s = i & (page_size - 1);
+        page& pg = *pages_[p];
+        pg.slots[s].reset();
+        pg.mask[s / 64] &= ~(std::uint64_t{1} << (s % 64));
+        --size_;
+        if (--pg.count == 0) {
+            pages_[p].reset();
+            page_mask_[p / 64] &= ~(std::uint64_t{1} << (p % 64));
+        }
+    }
+
+    /// @brief First occupied slot of page p at or after slot s, or page_size.
+    size_type next_in_page(size_type p, size_type s) const {
+        const page& pg = *pages_[p];
+        for (size_type w = s / 64; w < mask_words; ++w) {
+            std::uint64_t bits = pg.mask[w];
+            if (w == s / 64) bits &= ~std::uint64_t{0} << (s % 64);
+            if (bits) return w * 64 + static_cast<size_type>(std::countr_zero(bits));
+        }
+        return page_size;
+    }
+
+    /// @brief First allocated page at or after p, or page_count.
+    size_type next_page(size_type p) const {
+        for (size_type w = p / 64; w < page_mask_.size(); ++w) {
+            std::uint64_t bits = page_mask_[w];
+            if (w == p / 64) bits &= ~std::uint64_t{0} << (p % 64);
+            if (bits) return w * 64 + static_cast<size_type>(std::countr_zero(bits));
+        }
+        return page_count;
+    }
+
+    /// @brief Morton index of the first occupied slot at or after i, or npos.
+    size_type seek_index(size_type i) const {
+        const size_type first = i >> PageBits;
+        for (size_type p = next_page(first); p < page_count; p = next_page(p + 1)) {
+            size_type found = next_in_page(p, p == first ? (i & (page_size - 1)) : 0);
+            if (found < page_size) return (p << PageBits) | found;
+        }
+        return npos;
+    }
+
+    /// @brief Morton index of the first entry not below key, or npos.
+    size_type lower_bound_index(const Key& key) const {
+        const std::uint64_t code = static_cast<std::uint64_t>(key.encode());
+        if (code >= code_limit || size_ == 0) return npos;
+        return seek_index(static_cast<size_type>(code));
+    }
+
+    /// @brief Morton index of the first entry or npos.
+    size_type first_index() const { return size_ ? seek_index(0) : npos; }
+    /// @brief Morton index following i or npos.
+    size_type next_index(size_type i) const {
+        return i + 1 < code_limit ? seek_index(i + 1) : npos;
+    }
+
+    /// @brief Directory of lazily allocated pages.
+    std::vector<std::unique_ptr<page>> pages_{};
+    /// @brief Bit set for each allocated page.
+    std::vector<std::uint64_t> page_mask_{};
+    /// @brief Number of stored keys.
+    size_type size_{0};
+};
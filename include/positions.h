@@ -1,39 +1,21 @@
 #pragma once
 
+#include <cassert>
 #include <cstdint>
 #include <compare>
 #include <array>
 #include <cstddef>
-
-/// @brief Morton encode three 10-bit coordinates.
-constexpr std::uint32_t morton_encode(std::uint32_t x, std::uint32_t y, std::uint32_t z)
-{
-    std::uint32_t out = 0;
-    for (unsigned bit = 0; bit < 10; ++bit) {
-        out |= ((x >> bit) & 1u) << (3 * bit);
-        out |= ((y >> bit) & 1u) << (3 * bit + 1);
-        out |= ((z >> bit) & 1u) << (3 * bit + 2);
-    }
-    return out;
-}
-
-/// @brief Decode Morton code into coordinates.
-constexpr std::array<std::uint32_t, 3> morton_decode(std::uint32_t code)
-{
-    std::array<std::uint32_t, 3> p{0,0,0};
-    for (unsigned bit = 0; bit < 10; ++bit) {
-        p[0] |= ((code >> (3 * bit)) & 1u) << bit;
-        p[1] |= ((code >> (3 * bit + 1)) & 1u) << bit;
-        p[2] |= ((code >> (3 * bit + 2)) & 1u) << bit;
-    }
-    return p;
-}
+#include <bit>
+#include "morton.h"
 
 struct GlobalPosition;
 struct ChunkPosition;
 struct LocalPosition;
 
 /// @brief Chunk coordinate of the world.
+///
+/// Each coordinate must be below 2^21; ordering goes through the 63-bit
+/// Morton code, which keeps 21 bits per axis.
 struct ChunkPosition {
     /// @brief X chunk coordinate.
     std::uint32_t x{};
@@ -49,14 +31,45 @@ struct ChunkPosition {
 
     constexpr auto operator<=>(const ChunkPosition& other) const
     {
-        return morton_encode(x, y, z) <=> morton_encode(other.x, other.y, other.z);
+        return encode() <=> other.encode();
     }
     constexpr bool operator==(const ChunkPosition& other) const = default;
     /// @brief Convert to size type using Morton code.
-    constexpr operator std::size_t() const { return morton_encode(x, y, z); }
+    constexpr operator std::size_t() const { return static_cast<std::size_t>(encode()); }
+
+    /// @brief Morton encoded representation.
+    constexpr std::uint64_t encode() const
+    {
+        assert(x < (1u << 21) && y < (1u << 21) && z < (1u << 21) && "coordinate outside the 21-bit Morton range");
+        return morton_encode64(x, y, z);
+    }
+};
+
+/// @brief Chunk position carrying its precomputed Morton code.
+struct ChunkKey {
+    /// @brief Morton code of the chunk position.
+    std::uint64_t code{};
+    /// @brief Chunk coordinate.
+    ChunkPosition position{};
+
+    constexpr ChunkKey() = default;
+    constexpr ChunkKey(ChunkPosition p) : code(p.encode()), position(p) {}
+
+    /// @brief Order by the cached code with a single integer compare.
+    constexpr auto operator<=>(const ChunkKey& other) const { return code <=> other.code; }
+    constexpr bool operator==(const ChunkKey& other) const { return code == other.code; }
+    /// @brief Convert back to the plain chunk coordinate.
+    constexpr operator ChunkPosition() const { return position; }
+
+    /// @brief Morton encoded representation.
+    constexpr std::uint64_t encode() const { return code; }
 };
 
 /// @brief Local coordinate within a chunk.
+///
+/// Each coordinate must be below 64, the largest supported chunk edge;
+/// ordering goes through the 18-bit local Morton code, which only keeps
+/// those six bits per axis.
 struct LocalPosition {
     /// @brief X local coordinate.
     std::uint32_t x{};
@@ -68,7 +81,7 @@ struct LocalPosition {
     constexpr LocalPosition() = default;
     constexpr explicit LocalPosition(std::uint32_t code)
     {
-        auto p = morton_decode(code);
+        auto p = morton::decode_local(code);
         x = p[0];
         y = p[1];
         z = p[2];
@@ -79,14 +92,24 @@ struct LocalPosition {
 
     constexpr auto operator<=>(const LocalPosition& other) const
     {
-        return morton_encode(x, y, z) <=> morton_encode(other.x, other.y, other.z);
+        return encode() <=> other.encode();
     }
     constexpr bool operator==(const LocalPosition& other) const = default;
     /// @brief Convert to size type using Morton code.
-    constexpr operator std::size_t() const { return morton_encode(x, y, z); }
+    constexpr operator std::size_t() const { return encode(); }
+
+    /// @brief Morton encoded representation within a chunk of edge up to 64.
+    constexpr std::uint32_t encode() const
+    {
+        assert(x < 64 && y < 64 && z < 64 && "local coordinate outside a 64-edge chunk");
+        return morton::encode_local(x, y, z);
+    }
 };
 
 /// @brief Global coordinate in the world.
+///
+/// Each coordinate must be below 2^21; ordering goes through the 63-bit
+/// Morton code, which keeps 21 bits per axis.
 struct GlobalPosition {
     /// @brief X global coordinate.
     std::uint32_t x{};
@@ -96,9 +119,9 @@ struct GlobalPosition {
     std::uint32_t z{};
 
     constexpr GlobalPosition() = default;
-    constexpr explicit GlobalPosition(std::uint32_t code)
+    constexpr explicit GlobalPosition(std::uint64_t code)
     {
-        auto p = morton_decode(code);
+        auto p = morton_decode64(code);
         x = p[0];
         y = p[1];
         z = p[2];
@@ -110,7 +133,7 @@ struct GlobalPosition {
 
     constexpr auto operator<=>(const GlobalPosition& other) const
     {
-        return morton_encode(x, y, z) <=> morton_encode(other.x, other.y, other.z);
+        return encode() <=> other.encode();
     }
     constexpr bool operator==(const GlobalPosition& other) const = default;
 
@@ -121,18 +144,65 @@ struct GlobalPosition {
     }
 
     /// @brief Morton encoded representation.
-    constexpr std::uint32_t encode() const { return morton_encode(x, y, z); }
+    constexpr std::uint64_t encode() const
+    {
+        assert(x < (1u << 21) && y < (1u << 21) && z < (1u << 21) && "coordinate outside the 21-bit Morton range");
+        return morton_encode64(x, y, z);
+    }
 };
 
+/**
+ * @brief Split and combine helpers for cubic chunks with edge `Edge`.
+ *
+ * The edge must be a power of two between 2 and 64. For every such edge
+ * the global Morton code is the chunk code shifted left by `code_bits`
+ * with the local code in the low bits, so ordering by chunk and then by
+ * local position is global Morton order.
+ */
+template<std::uint32_t Edge>
+struct chunk_geometry {
+    static_assert(Edge >= 2 && Edge <= 64 && std::has_single_bit(Edge),
+                  "chunk edge must be a power of two in [2, 64]");
+
+    /// @brief Voxels along each chunk axis.
+    static constexpr std::uint32_t edge = Edge;
+    /// @brief Bits of a coordinate addressing the local position.
+    static constexpr unsigned shift = static_cast<unsigned>(std::countr_zero(Edge));
+    /// @brief Mask selecting the local part of a coordinate.
+    static constexpr std::uint32_t mask = Edge - 1;
+    /// @brief Bits of a local Morton code.
+    static constexpr unsigned code_bits = 3 * shift;
+    /// @brief Voxels per chunk.
+    static constexpr std::size_t volume = std::size_t{Edge} * Edge * Edge;
+
+    /// @brief Chunk containing a global position.
+    static constexpr ChunkPosition chunk_of(GlobalPosition g) {
+        return {g.x >> shift, g.y >> shift, g.z >> shift};
+    }
+    /// @brief Position of a global position inside its chunk.
+    static constexpr LocalPosition local_of(GlobalPosition g) {
+        return {g.x & mask, g.y & mask, g.z & mask};
+    }
+    /// @brief Global position of a local position inside a chunk.
+    static constexpr GlobalPosition combine(ChunkPosition c, LocalPosition l) {
+        return {(c.x << shift) | l.x, (c.y << shift) | l.y, (c.z << shift) | l.z};
+    }
+};
+
+/// @brief Geometry of the default 32x32x32 chunk.
+using default_chunk_geometry = chunk_geometry<32>;
+
 // ──────── out-of-class definitions ─────────
 constexpr ChunkPosition::ChunkPosition(GlobalPosition gp)
-    : x(gp.x >> 5), y(gp.y >> 5), z(gp.z >> 5) {}
+    : ChunkPosition(default_chunk_geometry::chunk_of(gp)) {}
 
 constexpr LocalPosition::LocalPosition(GlobalPosition gp)
-    : x(gp.x & 31), y(gp.y & 31), z(gp.z & 31) {}
+    : LocalPosition(default_chunk_geometry::local_of(gp)) {}
 
 constexpr GlobalPosition::GlobalPosition(ChunkPosition c)
-    : x(c.x << 5), y(c.y << 5), z(c.z << 5) {}
+    : x(c.x << default_chunk_geometry::shift),
+      y(c.y << default_chunk_geometry::shift),
+      z(c.z << default_chunk_geometry::shift) {}
 
 constexpr GlobalPosition::GlobalPosition(LocalPosition l)
     : x(l.x), y(l.y), z(l.z) {}
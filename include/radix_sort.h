@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <bit>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Stable permutation ordering 64-bit keys ascending.
+ *
+ * Returns the identity without sorting when the keys are already in
+ * order, which is the common case for output of set views. Otherwise an
+ * LSD radix sort with 11-bit digits runs over the significant bits only,
+ * so Morton codes of a small world need fewer passes. Equal keys keep
+ * their input order.
+ */
+inline std::vector<std::size_t> radix_sort_order(std::span<const std::uint64_t> keys)
+{
+    std::vector<std::size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    if (std::ranges::is_sorted(keys)) return order;
+    if (keys.size() < 64) {
+        std::ranges::stable_sort(order, {}, [&](std::size_t i) { return keys[i]; });
+        return order;
+    }
+
+    constexpr unsigned digit_bits = 11;
+    constexpr std::size_t radix = std::size_t{1} << digit_bits;
+    const std::uint64_t all_bits = std::reduce(keys.begin(), keys.end(), std::uint64_t{0},
+                                               [](std::uint64_t a, std::uint64_t b) { return a | b; });
+    const unsigned passes = (static_cast<unsigned>(std::bit_width(all_bits)) + digit_bits - 1) / digit_bits;
+
+    std::vector<std::pair<std::uint64_t, std::size_t>> cur(keys.size());
+    std::vector<std::pair<std::uint64_t, std::size_t>> next(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) cur[i] = {keys[i], i};
+    for (unsigned pass = 0; pass < passes; ++pass) {
+        const unsigned shift = pass * digit_bits;
+        std::array<std::size_t, radix> offsets{};
+        for (auto const& e : cur) ++offsets[(e.first >> shift) & (radix - 1)];
+        std::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin(), std::size_t{0});
+        for (auto const& e : cur) next[offsets[(e.first >> shift) & (radix - 1)]++] = e;
+        cur.swap(next);
+    }
+    for (std::size_t i = 0; i < cur.size(); ++i) order[i] = cur[i].second;
+    return order;
+}
@@ -2,13 +2,47 @@
 
 #include <ranges>
 #include <functional>
+#include <vector>
+#include <optional>
+#include <cstddef>
 #include "arrow_proxy.h"
 
 /// @brief Set operation enumeration used by set_view.
 enum class set_op { overlap, subtract, merge, exclusive };
 
+/**
+ * @brief Comparator ordering key/value pairs by key.
+ *
+ * Views built with key_less may skip ahead in an input whose iterator
+ * provides seek(key), moving to the first element whose key is not less
+ * than key. Sparse inputs are then stepped over in one seek instead of
+ * element by element.
+ */
+struct key_less {
+    template<typename A, typename B>
+    constexpr bool operator()(const A& a, const B& b) const { return a.first < b.first; }
+};
+
 namespace detail {
 
+    /// @brief Linear steps tried before an input is sought; dense overlaps never pay for a seek.
+    inline constexpr int seek_probes = 4;
+
+    /// @brief Advance it to the first element not ordered before target.
+    template<typename I, typename S, typename E, typename Comp>
+    void skip_before(I& it, const S& end, const E& target, const Comp& comp)
+    {
+        if constexpr (std::same_as<Comp, key_less> && requires { it.seek(target.first); }) {
+            for (int i = 0; i < seek_probes; ++i) {
+                if (it == end || !comp(*it, target)) return;
+                ++it;
+            }
+            if (it != end && comp(*it, target)) it.seek(target.first);
+        } else {
+            while (it != end && comp(*it, target)) ++it;
+        }
+    }
+
     /// @brief Iterator implementing lazy set algorithms.
     template<set_op Op, std::forward_iterator I1, std::sentinel_for<I1> S1,
              std::forward_iterator I2, std::sentinel_for<I2> S2, typename Comp>
@@ -43,7 +77,9 @@ namespace detail {
         /// @brief Equality comparison with sentinel.
         bool operator==(std::default_sentinel_t) const
         {
-            if constexpr (Op == set_op::overlap || Op == set_op::subtract)
+            if constexpr (Op == set_op::overlap)
+                return it1_ == end1_ || it2_ == end2_;
+            else if constexpr (Op == set_op::subtract)
                 return it1_ == end1_;
             else
                 return it1_ == end1_ && it2_ == end2_;
@@ -71,15 +107,15 @@ namespace detail {
         {
             if constexpr (Op == set_op::overlap) {
                 while (it1_ != end1_ && it2_ != end2_) {
-                    if ((*comp_)(*it1_, *it2_)) ++it1_;
-                    else if ((*comp_)(*it2_, *it1_)) ++it2_;
+                    if ((*comp_)(*it1_, *it2_)) skip_before(it1_, end1_, *it2_, *comp_);
+                    else if ((*comp_)(*it2_, *it1_)) skip_before(it2_, end2_, *it1_, *comp_);
                     else break;
                 }
                 use_first_ = true;
             } else if constexpr (Op == set_op::subtract) {
                 while (it1_ != end1_ && it2_ != end2_) {
                     if ((*comp_)(*it1_, *it2_)) break;
-                    if ((*comp_)(*it2_, *it1_)) ++it2_;
+                    if ((*comp_)(*it2_, *it1_)) skip_before(it2_, end2_, *it1_, *comp_);
                     else { ++it1_; ++it2_; }
                 }
                 use_first_ = true;
@@ -172,6 +208,210 @@ namespace detail {
         }
     };
 
+    /**
+     * @brief Iterator merging or overlapping any number of sorted ranges.
+     *
+     * The input heads are kept in a loser tree: node 0 holds the input with
+     * the smallest head and every other node the loser of the match played
+     * there, so stepping the winner replays one leaf-to-root path of
+     * log2(k) comparisons. Ties go to the lower input, which makes the first
+     * range's element win on shared keys. Overlap steps the smallest head up
+     * to the largest until all heads agree.
+     *
+     * Inputs whose iterators return proxies by value have each head
+     * dereferenced once and cached, since a match reads it repeatedly.
+     */
+    template<set_op Op, std::forward_iterator I, std::sentinel_for<I> S, typename Comp>
+    class nary_set_iter {
+        static_assert(Op == set_op::merge || Op == set_op::overlap,
+                      "n-ary set views support merge and overlap");
+    public:
+        using value_type = std::remove_cvref_t<std::iter_reference_t<I>>;
+        using reference  = std::iter_reference_t<I>;
+        using pointer    = arrow_proxy<reference>;
+        using difference_type = std::ptrdiff_t;
+        using iterator_concept = std::forward_iterator_tag;
+
+        nary_set_iter() = default;
+        /// @brief Construct iterator from per-range state.
+        nary_set_iter(std::vector<I> its, std::vector<S> ends, const Comp* comp)
+            : its_(std::move(its)), ends_(std::move(ends)), comp_(comp)
+        {
+            if constexpr (cache_heads) heads_.resize(its_.size());
+            build();
+            if constexpr (Op == set_op::overlap) satisfy();
+        }
+
+        /// @brief Dereference current element.
+        reference operator*() const { return head(Op == set_op::overlap ? 0 : tree_[0]); }
+        /// @brief Arrow operator for structured bindings.
+        pointer operator->() const { return pointer{**this}; }
+
+        /// @brief Pre-increment iterator.
+        nary_set_iter& operator++()
+        {
+            if constexpr (Op == set_op::merge) {
+                reference prev = head(tree_[0]);
+                step(tree_[0]);
+                while (!exhausted(tree_[0]) && !(*comp_)(prev, head(tree_[0]))) step(tree_[0]);
+            } else {
+                for (auto& it : its_) ++it;
+                build();
+                satisfy();
+            }
+            return *this;
+        }
+        /// @brief Post-increment iterator.
+        nary_set_iter operator++(int) { auto t = *this; ++(*this); return t; }
+
+        /// @brief Equality comparison with sentinel.
+        bool operator==(std::default_sentinel_t) const
+        {
+            if constexpr (Op == set_op::overlap) return done_;
+            else return its_.empty() || exhausted(tree_[0]);
+        }
+
+    private:
+        static constexpr bool cache_heads = !std::is_reference_v<reference>;
+        struct no_heads {};
+
+        /// @brief Cached proxy head; reassigned by re-emplacing, as proxies may hold references.
+        struct cached_head {
+            std::optional<reference> value{};
+            cached_head() = default;
+            cached_head(const cached_head&) = default;
+            cached_head& operator=(const cached_head& o)
+            {
+                if (this != &o) {
+                    value.reset();
+                    if (o.value) value.emplace(*o.value);
+                }
+                return *this;
+            }
+        };
+
+        bool exhausted(std::size_t i) const { return its_[i] == ends_[i]; }
+
+        /// @brief Current element of input i, which must not be exhausted.
+        decltype(auto) head(std::size_t i) const
+        {
+            if constexpr (cache_heads) return *heads_[i].value;
+            else return *its_[i];
+        }
+
+        /// @brief Refresh the cached head of input i after it moved.
+        void load(std::size_t i)
+        {
+            if constexpr (cache_heads) {
+                if (exhausted(i)) heads_[i].value.reset();
+                else heads_[i].value.emplace(*its_[i]);
+            }
+        }
+
+        /// @brief True if input a's head comes before input b's; index k stands below everything.
+        bool beats(std::size_t a, std::size_t b) const
+        {
+            const std::size_t k = its_.size();
+            if (a == k || b == k) return a == k && b != k;
+            if (exhausted(a) || exhausted(b)) return !exhausted(a);
+            if ((*comp_)(head(a), head(b))) return true;
+            if ((*comp_)(head(b), head(a))) return false;
+            return a < b;
+        }
+
+        /// @brief Play input s's head from its leaf up to the root.
+        void replay(std::size_t s)
+        {
+            for (std::size_t t = (s + its_.size()) / 2; t > 0; t /= 2)
+                if (beats(tree_[t], s)) std::swap(s, tree_[t]);
+            tree_[0] = s;
+        }
+
+        /// @brief Advance input i by one element.
+        void step(std::size_t i) { ++its_[i]; load(i); replay(i); }
+
+        void build()
+        {
+            const std::size_t k = its_.size();
+            for (std::size_t i = 0; i < k; ++i) load(i);
+            tree_.assign(k, k);
+            for (std::size_t i = k; i-- > 0;) replay(i);
+            if constexpr (Op == set_op::overlap) {
+                done_ = k == 0;
+                hi_ = 0;
+                for (std::size_t i = 0; i < k && !done_; ++i) {
+                    if (exhausted(i)) done_ = true;
+                    else if ((*comp_)(head(hi_), head(i))) hi_ = i;
+                }
+            }
+        }
+
+        void satisfy()
+        {
+            while (!done_) {
+                const std::size_t w = tree_[0];
+                if (!(*comp_)(head(w), head(hi_))) return;
+                skip_before(its_[w], ends_[w], head(hi_), *comp_);
+                load(w);
+                replay(w);
+                if (exhausted(w)) done_ = true;
+                else if ((*comp_)(head(hi_), head(w))) hi_ = w;
+            }
+        }
+
+        std::vector<I> its_{};           ///< @brief Head of each range.
+        std::vector<S> ends_{};          ///< @brief Sentinel of each range.
+        [[no_unique_address]] std::conditional_t<cache_heads,
+            std::vector<cached_head>, no_heads> heads_{}; ///< @brief Cached proxy heads.
+        std::vector<std::size_t> tree_{}; ///< @brief Loser tree over input indices; tree_[0] is the winner.
+        const Comp* comp_{nullptr};      ///< @brief Pointer to comparator.
+        std::size_t hi_{0};              ///< @brief Input with the largest head (overlap only).
+        bool done_{false};               ///< @brief Some input ran out (overlap only).
+    };
+
+    /// @brief Helper view storing any number of ranges for a set operation.
+    template<set_op Op, std::ranges::forward_range R, typename Comp>
+    class nary_set_view : public std::ranges::view_interface<nary_set_view<Op,R,Comp>> {
+        using I = std::ranges::iterator_t<R>;
+        using S = std::ranges::sentinel_t<R>;
+    public:
+        /// @brief Construct view from ranges and comparator.
+        nary_set_view(std::vector<R> ranges, Comp comp)
+            : ranges_(std::move(ranges)), comp_(std::move(comp)) {}
+
+        /// @brief Iterator to first element.
+        auto begin()
+        {
+            std::vector<I> its;
+            std::vector<S> ends;
+            its.reserve(ranges_.size());
+            ends.reserve(ranges_.size());
+            for (auto& r : ranges_) {
+                its.push_back(std::ranges::begin(r));
+                ends.push_back(std::ranges::end(r));
+            }
+            return nary_set_iter<Op,I,S,Comp>{std::move(its), std::move(ends), &comp_};
+        }
+        /// @brief End sentinel.
+        std::default_sentinel_t end() { return {}; }
+    private:
+        std::vector<R> ranges_; ///< @brief Input ranges.
+        Comp comp_;             ///< @brief Comparator instance.
+    };
+
+    template<set_op Op>
+    struct nary_adaptor {
+        template<std::ranges::input_range Rs, typename Comp = std::ranges::less>
+            requires std::ranges::forward_range<std::ranges::range_reference_t<Rs>>
+        auto operator()(Rs&& ranges, Comp comp = {}) const
+        {
+            using R = std::views::all_t<std::ranges::range_reference_t<Rs>>;
+            std::vector<R> all;
+            for (auto&& r : ranges) all.push_back(std::views::all(std::forward<decltype(r)>(r)));
+            return nary_set_view<Op, R, Comp>(std::move(all), std::move(comp));
+        }
+    };
+
 } // namespace detail
 
 namespace views {
@@ -183,5 +423,9 @@ namespace views {
     inline constexpr detail::view_adaptor<set_op::merge> merge{};
     /// @brief Lazy exclusive difference of two sorted ranges.
     inline constexpr detail::view_adaptor<set_op::exclusive> exclusive{};
+    /// @brief Lazy merge of a range of sorted ranges in one pass.
+    inline constexpr detail::nary_adaptor<set_op::merge> merge_n{};
+    /// @brief Lazy overlap of a range of sorted ranges in one pass.
+    inline constexpr detail::nary_adaptor<set_op::overlap> overlap_n{};
 } // namespace views
 
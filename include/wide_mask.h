@@ -0,0 +1,198 @@
+#pragma once
+
+#include <experimental/simd>
+#include <array>
+#include <bit>
+#include <bitset>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief Bit mask wider than a machine word, for buckets of 256 or 512 keys.
+ *
+ * Bits are stored in 64-bit words, lowest bit first. The bitwise operators
+ * work on all words at once through a fixed-size SIMD vector, so an AND of
+ * two 256-bit masks is a single AVX2 instruction where available and a pair
+ * of SSE2 ones otherwise. Construction from an integer, `~`, `<<` by a bit
+ * count and contextual conversion to bool behave as for unsigned integers,
+ * which lets the mask stand in for one as a bucket_map Bucket.
+ */
+template<std::size_t Bits>
+class wide_mask {
+    static_assert(Bits > 0 && Bits % 64 == 0, "wide_mask width must be a multiple of 64");
+public:
+    /// @brief Number of 64-bit words.
+    static constexpr std::size_t words = Bits / 64;
+    /// @brief SIMD vector holding all words.
+    using simd_type = std::experimental::fixed_size_simd<std::uint64_t, static_cast<int>(words)>;
+
+    /// @brief Empty mask.
+    constexpr wide_mask() = default;
+    /// @brief Mask with the bits of low in its lowest word.
+    constexpr wide_mask(std::uint64_t low) { w_[0] = low; }
+
+    /// @brief Word i of the mask.
+    constexpr std::uint64_t word(std::size_t i) const { return w_[i]; }
+    /// @brief Set word i of the mask.
+    constexpr void set_word(std::size_t i, std::uint64_t v) { w_[i] = v; }
+
+    /// @brief True if bit is set.
+    constexpr bool test(std::size_t bit) const { return (w_[bit / 64] >> (bit % 64)) & 1u; }
+    /// @brief Set bit.
+    constexpr void set(std::size_t bit) { w_[bit / 64] |= std::uint64_t{1} << (bit % 64); }
+
+    /// @brief True if any bit is set.
+    explicit operator bool() const { return std::experimental::any_of(load() != 0); }
+
+    /// @brief Bitwise complement.
+    wide_mask operator~() const { return from(~load()); }
+    /// @brief Bitwise AND.
+    friend wide_mask operator&(const wide_mask& a, const wide_mask& b) { return from(a.load() & b.load()); }
+    /// @brief Bitwise OR.
+    friend wide_mask operator|(const wide_mask& a, const wide_mask& b) { return from(a.load() | b.load()); }
+    /// @brief Bitwise XOR.
+    friend wide_mask operator^(const wide_mask& a, const wide_mask& b) { return from(a.load() ^ b.load()); }
+    /// @brief In-place AND.
+    wide_mask& operator&=(const wide_mask& o) { return *this = *this & o; }
+    /// @brief In-place OR.
+    wide_mask& operator|=(const wide_mask& o) { return *this = *this | o; }
+    /// @brief In-place XOR.
+    wide_mask& operator^=(const wide_mask& o) { return *this = *this ^ o; }
+
+    /// @brief Shift towards higher bits; bits shifted past the top are lost.
+    constexpr wide_mask operator<<(std::size_t n) const {
+        wide_mask out;
+        if (n >= Bits) return out;
+        const std::size_t ws = n / 64;
+        const unsigned bs = static_cast<unsigned>(n % 64);
+        for (std::size_t i = words; i-- > ws;) {
+            std::uint64_t v = w_[i - ws] << bs;
+            if (bs != 0 && i > ws) v |= w_[i - ws - 1] >> (64 - bs);
+            out.w_[i] = v;
+        }
+        return out;
+    }
+
+    /// @brief Equality comparison.
+    friend bool operator==(const wide_mask&, const wide_mask&) = default;
+
+private:
+    /// @brief Words as a SIMD vector.
+    simd_type load() const { return simd_type(w_.data(), std::experimental::vector_aligned); }
+    /// @brief Mask holding the words of v.
+    static wide_mask from(const simd_type& v) {
+        wide_mask out;
+        v.copy_to(out.w_.data(), std::experimental::vector_aligned);
+        return out;
+    }
+
+    /// @brief Words, lowest first, aligned for whole-vector loads.
+    alignas(std::experimental::memory_alignment_v<simd_type>) std::array<std::uint64_t, words> w_{};
+};
+
+/// @brief Number of bits in a bucket mask type.
+template<typename Mask> struct mask_traits {
+    static constexpr std::size_t bits = std::numeric_limits<Mask>::digits;
+};
+template<std::size_t Bits> struct mask_traits<wide_mask<Bits>> {
+    static constexpr std::size_t bits = Bits;
+};
+
+/// @brief True for wide_mask specializations.
+template<typename Mask> inline constexpr bool is_wide_mask_v = false;
+template<std::size_t Bits> inline constexpr bool is_wide_mask_v<wide_mask<Bits>> = true;
+
+/// @brief Types usable as a bucket mask: unsigned integers and wide masks.
+template<typename Mask>
+concept bucket_mask = std::unsigned_integral<Mask> || is_wide_mask_v<Mask>;
+
+/// @brief Number of set bits.
+template<std::unsigned_integral Mask>
+constexpr int mask_popcount(Mask m) { return std::popcount(m); }
+template<std::size_t Bits>
+constexpr int mask_popcount(const wide_mask<Bits>& m) {
+    int n = 0;
+    for (std::size_t i = 0; i < wide_mask<Bits>::words; ++i) n += std::popcount(m.word(i));
+    return n;
+}
+
+/// @brief Index of the lowest set bit, the mask width if none is set.
+template<std::unsigned_integral Mask>
+constexpr int mask_countr_zero(Mask m) { return std::countr_zero(m); }
+template<std::size_t Bits>
+constexpr int mask_countr_zero(const wide_mask<Bits>& m) {
+    for (std::size_t i = 0; i < wide_mask<Bits>::words; ++i)
+        if (m.word(i)) return static_cast<int>(i * 64) + std::countr_zero(m.word(i));
+    return static_cast<int>(Bits);
+}
+
+/// @brief The mask without its lowest set bit.
+template<std::unsigned_integral Mask>
+constexpr Mask mask_clear_lowest(Mask m) { return m & (m - 1); }
+template<std::size_t Bits>
+constexpr wide_mask<Bits> mask_clear_lowest(const wide_mask<Bits>& mask) {
+    wide_mask<Bits> m = mask;
+    for (std::size_t i = 0; i < wide_mask<Bits>::words; ++i) {
+        if (const std::uint64_t w = m.word(i)) {
+            m.set_word(i, w & (w - 1));
+            break;
+        }
+    }
+    return m;
+}
+
+/// @brief True if bit is set.
+template<std::unsigned_integral Mask>
+constexpr bool mask_test(Mask m, std::size_t bit) { return (m >> bit) & 1u; }
+template<std::size_t Bits>
+constexpr bool mask_test(const wide_mask<Bits>& m, std::size_t bit) { return m.test(bit); }
+
+/// @brief Mask holding the bits of a bitset of the same width.
+template<bucket_mask Mask>
+Mask mask_from_bitset(const std::bitset<mask_traits<Mask>::bits>& bs) {
+    if constexpr (std::unsigned_integral<Mask>) {
+        return static_cast<Mask>(bs.to_ullong());
+    } else {
+        constexpr std::bitset<mask_traits<Mask>::bits> low{~std::uint64_t{0}};
+        Mask out;
+        for (std::size_t i = 0; i < Mask::words; ++i)
+            out.set_word(i, ((bs >> (i * 64)) & low).to_ullong());
+        return out;
+    }
+}
+
+/// @brief Bitset holding the bits of a mask.
+template<bucket_mask Mask>
+std::bitset<mask_traits<Mask>::bits> mask_to_bitset(const Mask& m) {
+    if constexpr (std::unsigned_integral<Mask>) {
+        return std::bitset<mask_traits<Mask>::bits>(m);
+    } else {
+        std::bitset<mask_traits<Mask>::bits> out;
+        for (std::size_t i = Mask::words; i-- > 0;) {
+            out <<= 64;
+            out |= std::bitset<mask_traits<Mask>::bits>(m.word(i));
+        }
+        return out;
+    }
+}
+
+/// @brief Invoke function for each set bit in a mask.
+template<typename Bucket, typename Fn>
+static void for_each_set_bit(Bucket mask, Fn&& fn)
+{
+    while (mask) {
+        auto bit = std::countr_zero(mask);
+        fn(static_cast<std::size_t>(bit));
+        mask &= mask - 1;
+    }
+}
+
+/// @brief Invoke function for each set bit in a wide mask, a word at a time.
+template<std::size_t Bits, typename Fn>
+static void for_each_set_bit(const wide_mask<Bits>& mask, Fn&& fn)
+{
+    for (std::size_t i = 0; i < wide_mask<Bits>::words; ++i)
+        for_each_set_bit(mask.word(i), [&](std::size_t bit) { fn(i * 64 + bit); });
+}
@@ -0,0 +1,53 @@
+#include "doctest.h"
+#include "array_packed.h"
+#include "benchmark.h"
+#include "test_random.h"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Time bucket-shaped use of array_packed with one plane storage.
+ *
+ * Keys index 64-lane buckets holding small value indices, as in
+ * bucket_map; insert writes lanes one at a time and iterate decodes each
+ * bucket once. The copy benchmark takes a temporary copy of every
+ * bucket, which a heap-backed array pays an allocation for.
+ */
+template<typename Storage>
+static void bench_plane_storage(const std::string& name)
+{
+    using arr_t = array_packed<64, int, plain_encoding, Storage>;
+    constexpr std::size_t keys = std::size_t{1} << 20;
+
+    std::vector<arr_t> buckets;
+    BENCHMARK(name + " insert 1M keys") {
+        buckets.assign(keys / 64, arr_t{});
+        test_rng rng(1);
+        for (std::size_t i = 0; i < keys; ++i) {
+            const std::size_t key = rng.below(keys);
+            buckets[key / 64][key % 64] = static_cast<int>(1 + rng.below(12));
+        }
+    }
+    long sum = 0;
+    BENCHMARK(name + " iterate 1M keys") {
+        for (const auto& bucket : buckets)
+            for (int v : bucket.load_all()) sum += v;
+    }
+    long copied = 0;
+    BENCHMARK(name + " copy 16k buckets 10 times") {
+        for (int round = 0; round < 10; ++round) {
+            for (std::size_t b = 0; b < buckets.size(); ++b) {
+                const arr_t copy = buckets[b];
+                copied += copy[b % 64];
+            }
+        }
+    }
+    CHECK(sum > 0);
+    CHECK(copied > 0);
+}
+
+TEST_CASE("array_packed plane storage benchmark") {
+    bench_plane_storage<heap_planes>("heap planes");
+    bench_plane_storage<fixed_planes<>>("fixed planes");
+    bench_plane_storage<small_planes<4>>("small planes");
+}
@@ -0,0 +1,158 @@
+#include "doctest.h"
+#include "chunk_map.h"
+#include "layered_map.h"
+#include "aabb.h"
+#include "benchmark.h"
+#include "test_random.h"
+#include <vector>
+
+/// @brief chunk_map keyed by plain ChunkPosition, recomputing codes per compare.
+using position_keyed_map = chunk_map<int, std::map<LocalPosition, int>,
+                                     std::map<ChunkPosition, std::map<LocalPosition, int>>>;
+/// @brief chunk_map keyed by ChunkKey with cached codes.
+using code_keyed_map = chunk_map<int>;
+
+/// @brief layered_map variant keyed by plain ChunkPosition.
+using position_keyed_layered = chunk_map<int, bucket_map<LocalPosition, int>,
+                                         std::map<ChunkPosition, bucket_map<LocalPosition, int>>>;
+
+/// @brief Fill a map of type Map with an axis aligned box.
+template<typename Map>
+static Map make_box(GlobalPosition lo, GlobalPosition hi)
+{
+    Map map;
+    for (GlobalPosition p : GlobalAabb{lo, hi}) map[p] = 1;
+    return map;
+}
+
+TEST_CASE("chunk key insert and find benchmark") {
+    auto pts = random_positions(1 << 14, 256, 11);
+
+    position_keyed_map before;
+    BENCHMARK("insert ChunkPosition keys") {
+        for (auto p : pts) before.insert({p, 1});
+    }
+    code_keyed_map after;
+    BENCHMARK("insert ChunkKey keys") {
+        for (auto p : pts) after.insert({p, 1});
+    }
+
+    std::size_t found_before = 0;
+    BENCHMARK("find ChunkPosition keys") {
+        for (auto p : pts) found_before += before.find(p) != before.end();
+    }
+    std::size_t found_after = 0;
+    BENCHMARK("find ChunkKey keys") {
+        for (auto p : pts) found_after += after.find(p) != after.end();
+    }
+
+    CHECK(found_before == pts.size());
+    CHECK(found_after == pts.size());
+    CHECK(before.size() == after.size());
+}
+
+TEST_CASE("chunk key layered csg benchmark") {
+    auto lhs_before = make_box<position_keyed_layered>({0,0,0}, {32,32,32});
+    auto rhs_before = make_box<position_keyed_layered>({16,16,16}, {48,48,48});
+    auto lhs_after = make_box<layered_map<int>>({0,0,0}, {32,32,32});
+    auto rhs_after = make_box<layered_map<int>>({16,16,16}, {48,48,48});
+
+    position_keyed_layered uni_before, inter_before;
+    BENCHMARK("union ChunkPosition keys") {
+        uni_before = std::ranges::to<position_keyed_layered>(
+            position_keyed_layered::merge(lhs_before, rhs_before));
+    }
+    BENCHMARK("intersection ChunkPosition keys") {
+        inter_before = std::ranges::to<position_keyed_layered>(
+            position_keyed_layered::overlap(lhs_before, rhs_before));
+    }
+
+    layered_map<int> uni_after, inter_after;
+    BENCHMARK("union ChunkKey keys") {
+        uni_after = std::ranges::to<layered_map<int>>(
+            layered_map<int>::merge(lhs_after, rhs_after));
+    }
+    BENCHMARK("intersection ChunkKey keys") {
+        inter_after = std::ranges::to<layered_map<int>>(
+            layered_map<int>::overlap(lhs_after, rhs_after));
+    }
+
+    CHECK(uni_before.size() == uni_after.size());
+    CHECK(inter_before.size() == inter_after.size());
+    CHECK(inter_after.size() == 16u * 16u * 16u);
+}
+
+TEST_CASE("chunk_hash_map outer map benchmark") {
+    auto pts = random_positions(1 << 14, 256, 11);
+
+    layered_map<int> tree;
+    BENCHMARK("insert std::map outer") {
+        for (auto p : pts) tree.insert({p, 1});
+    }
+    hashed_layered_map<int> hashed;
+    BENCHMARK("insert chunk_hash_map outer") {
+        for (auto p : pts) hashed.insert({p, 1});
+    }
+
+    std::size_t found_tree = 0;
+    BENCHMARK("find std::map outer") {
+        for (auto p : pts) found_tree += tree.find(p) != tree.end();
+    }
+    std::size_t found_hashed = 0;
+    BENCHMARK("find chunk_hash_map outer") {
+        for (auto p : pts) found_hashed += hashed.find(p) != hashed.end();
+    }
+
+    std::size_t visited = 0;
+    BENCHMARK("ordered iteration chunk_hash_map outer") {
+        for (auto const& e : hashed) visited += e.second;
+    }
+
+    CHECK(found_tree == pts.size());
+    CHECK(found_hashed == pts.size());
+    CHECK(visited == tree.size());
+    CHECK(std::ranges::equal(tree, hashed));
+}
+
+TEST_CASE("paged_chunk_table outer map benchmark") {
+    auto pts = random_positions(1 << 14, 256, 11);
+
+    layered_map<int> tree;
+    BENCHMARK("insert std::map outer") {
+        for (auto p : pts) tree.insert({p, 1});
+    }
+    paged_layered_map<int> paged;
+    BENCHMARK("insert paged_chunk_table outer") {
+        for (auto p : pts) paged.insert({p, 1});
+    }
+
+    std::size_t found_tree = 0;
+    BENCHMARK("find std::map outer") {
+        for (auto p : pts) found_tree += tree.find(p) != tree.end();
+    }
+    std::size_t found_paged = 0;
+    BENCHMARK("find paged_chunk_table outer") {
+        for (auto p : pts) found_paged += paged.find(p) != paged.end();
+    }
+
+    CHECK(found_tree == pts.size());
+    CHECK(found_paged == pts.size());
+    CHECK(std::ranges::equal(tree, paged));
+}
+
+TEST_CASE("hot chunk cache benchmark") {
+    GlobalAabb brush{{0, 0, 0}, {96, 96, 64}};
+
+    code_keyed_map map;
+    BENCHMARK("coherent writes") {
+        for (GlobalPosition p : brush) map[p] = 1;
+    }
+    std::size_t found = 0;
+    BENCHMARK("coherent finds") {
+        for (GlobalPosition p : brush) found += map.find(p) != map.end();
+    }
+
+    auto stats = map.cache_stats();
+    CHECK(found == map.size());
+    CHECK(stats.hit_rate() > 0.9);
+}
@@ -3,15 +3,26 @@
 #include "layered_map_algo.h"
 #include "aabb.h"
 #include "benchmark.h"
+#include "csg_expression.h"
+#include "test_random.h"
+#include <string>
+#include <concepts>
+#include <ranges>
 
-/// @brief Create a filled axis aligned box.
+/// @brief Create a filled axis aligned box; value is an int or a function of the position.
+template<typename Value = int>
 static layered_map<int> make_box(GlobalPosition min_corner,
                                  GlobalPosition max_corner,
-                                 int value = 1)
+                                 Value value = 1)
 {
     layered_map<int> map;
-    for (GlobalPosition p : GlobalAabb{min_corner, max_corner})
-        map[p] = value;
+    map.assign_sorted(GlobalAabb{min_corner, max_corner}
+                      | std::views::transform([=](GlobalPosition p) {
+                            if constexpr (std::invocable<const Value&, GlobalPosition>)
+                                return std::pair{p, static_cast<int>(value(p))};
+                            else
+                                return std::pair{p, static_cast<int>(value)};
+                        }));
     return map;
 }
 
@@ -38,3 +49,430 @@ TEST_CASE("layered_map csg benchmark") {
     CHECK(inter.size() > 0);
     CHECK(diff.size() > 0);
 }
+
+/// @brief Time voxel-wise set views against chunk-level combine on two boxes.
+static void chunk_csg_benchmark(std::uint32_t edge)
+{
+    const std::uint32_t half = edge / 2;
+    auto lhs = make_box({0,0,0}, {edge,edge,edge}, 1);
+    auto rhs = make_box({half,half,half}, {edge + half,edge + half,edge + half}, 2);
+
+    layered_map<int> by_view;
+    layered_map<int> by_chunk;
+    BENCHMARK("union via set views") {
+        by_view.clear();
+        by_view.assign_sorted(layered_map<int>::merge(lhs, rhs));
+    }
+    BENCHMARK("union via chunk combine") {
+        by_chunk = lhs | rhs;
+    }
+    CHECK(std::ranges::equal(by_view, by_chunk));
+
+    BENCHMARK("intersection via set views") {
+        by_view.clear();
+        by_view.assign_sorted(layered_map<int>::overlap(lhs, rhs));
+    }
+    BENCHMARK("intersection via chunk combine") {
+        by_chunk = lhs & rhs;
+    }
+    CHECK(std::ranges::equal(by_view, by_chunk));
+
+    BENCHMARK("difference via set views") {
+        by_view.clear();
+        by_view.assign_sorted(layered_map<int>::subtract(lhs, rhs));
+    }
+    BENCHMARK("difference via chunk combine") {
+        by_chunk = lhs - rhs;
+    }
+    CHECK(std::ranges::equal(by_view, by_chunk));
+}
+
+TEST_CASE("chunk-level csg benchmark 50^3") {
+    chunk_csg_benchmark(50);
+}
+
+// 125M voxels per operand: staging the inputs needs several GB and minutes.
+TEST_CASE("chunk-level csg benchmark 500^3" * doctest::skip()) {
+    chunk_csg_benchmark(500);
+}
+
+TEST_CASE("in-place brush benchmark") {
+    auto world = make_box({0,0,0}, {128,128,64});
+    std::vector<layered_map<int>> brushes;
+    test_rng rng(7);
+    for (int i = 0; i < 1000; ++i) {
+        GlobalPosition lo{rng.below(120), rng.below(120), rng.below(56)};
+        brushes.push_back(make_box(lo, lo + GlobalPosition{4, 4, 4}, 2 + i % 3));
+    }
+
+    auto rebuilt = world;
+    BENCHMARK("100 brushes rebuilding the map") {
+        for (std::size_t i = 0; i < 100; ++i) {
+            rebuilt = rebuilt | brushes[i];
+            rebuilt = rebuilt - brushes[i + 1];
+        }
+    }
+    auto edited = world;
+    BENCHMARK("100 brushes in place") {
+        for (std::size_t i = 0; i < 100; ++i) {
+            edited |= brushes[i];
+            edited -= brushes[i + 1];
+        }
+    }
+    CHECK(std::ranges::equal(rebuilt, edited));
+
+    BENCHMARK("1000 brushes in place") {
+        for (std::size_t i = 0; i + 1 < brushes.size(); ++i) {
+            edited |= brushes[i];
+            edited -= brushes[i + 1];
+        }
+    }
+    CHECK(edited.size() < world.size());
+}
+
+TEST_CASE("fused csg expression benchmark") {
+    auto a = make_box({0,0,0}, {96,96,96}, 1);
+    auto b = make_box({64,0,0}, {160,96,96}, 2);
+    auto c = make_box({0,40,40}, {160,56,56}, 3);
+    auto d = make_box({32,0,0}, {128,64,64}, 4);
+
+    layered_map<int> eager;
+    BENCHMARK("(a | b) - (c & d) with temporaries") {
+        eager = (a | b) - (c & d);
+    }
+    layered_map<int> fused;
+    BENCHMARK("(a | b) - (c & d) fused") {
+        fused = csg::evaluate((csg::lazy(a) | b) - (csg::lazy(c) & d));
+    }
+    std::size_t streamed = 0;
+    BENCHMARK("(a | b) - (c & d) streamed") {
+        csg::evaluate((csg::lazy(a) | b) - (csg::lazy(c) & d),
+                      [&](GlobalPosition, int) { ++streamed; });
+    }
+    CHECK(std::ranges::equal(eager, fused));
+    CHECK(streamed == eager.size());
+}
+
+TEST_CASE("seeking set view benchmark") {
+    auto world = make_box({0,0,0}, {128,128,128});
+    layered_map<int> brush;
+    for (std::uint32_t i = 0; i < 100; ++i)
+        brush[GlobalPosition{i, i % 50 + 3, i * 7 % 120}] = 2;
+
+    auto linear = [](auto const& a, auto const& b) { return a.first < b.first; };
+    std::size_t stepped = 0;
+    BENCHMARK("100-voxel brush & 2M world stepping") {
+        stepped = std::ranges::distance(views::overlap(world, brush, linear));
+    }
+    std::size_t sought = 0;
+    BENCHMARK("100-voxel brush & 2M world seeking") {
+        sought = std::ranges::distance(views::overlap(world, brush, key_less{}));
+    }
+    CHECK(stepped == brush.size());
+    CHECK(sought == brush.size());
+}
+
+TEST_CASE("n-ary merge benchmark") {
+    std::vector<layered_map<int>> maps;
+    for (std::uint32_t i = 0; i < 24; ++i)
+        maps.push_back(make_box(GlobalPosition{3 * i, 0, 0}, GlobalPosition{3 * i + 24, 24, 24}, static_cast<int>(i)));
+
+    layered_map<int> chained;
+    BENCHMARK("union of 24 maps as chained views") {
+        chained = maps[0];
+        for (std::size_t i = 1; i < maps.size(); ++i) {
+            layered_map<int> next;
+            next.insert_range(views::merge(chained, maps[i], key_less{}));
+            chained = std::move(next);
+        }
+    }
+    layered_map<int> merged;
+    BENCHMARK("union of 24 maps with merge_n") {
+        merged = layered_map<int>{};
+        merged.assign_sorted(views::merge_n(maps, key_less{}));
+    }
+    CHECK(std::ranges::equal(chained, merged));
+}
+
+TEST_CASE("layered_map copy and move benchmark") {
+    auto world = make_box({0,0,0}, {100,100,100},
+                          [](GlobalPosition p) { return (p.x + p.y) % 5; });
+
+    layered_map<int> copy;
+    BENCHMARK("copy 1M voxels") {
+        copy = world;
+    }
+    layered_map<int> moved;
+    BENCHMARK("move 1M voxels") {
+        moved = std::move(copy);
+    }
+    std::vector<bucket_map<LocalPosition, int>> chunks;
+    world.for_each_chunk([&](ChunkPosition, auto const& inner) { chunks.push_back(inner); });
+    std::vector<bucket_map<LocalPosition, int>> relocated;
+    BENCHMARK("move every chunk of 1M voxels") {
+        for (auto& chunk : chunks) relocated.push_back(std::move(chunk));
+    }
+    CHECK(moved.size() == world.size());
+    CHECK(copy.empty());
+    CHECK(relocated.size() == chunks.size());
+}
+
+/// @brief Set operations and iteration over 256k keys with Bucket-wide buckets.
+template<typename Bucket>
+static void bench_bucket_width(const std::string& width)
+{
+    using map_t = bucket_map<std::size_t, int, Bucket>;
+    map_t lhs;
+    map_t rhs;
+    for (std::size_t k = 0; k < (std::size_t{1} << 18); ++k) {
+        if ((k / 1000) % 3 != 2) lhs.insert_or_assign(k, static_cast<int>(k / 4096 % 4));
+        if ((k / 700) % 2) rhs.insert_or_assign(k, static_cast<int>(k / 8192 % 3));
+    }
+
+    map_t uni;
+    BENCHMARK(width + "-key buckets union") {
+        uni = map_t::template combine<set_op::merge>(lhs, rhs);
+    }
+    map_t inter;
+    BENCHMARK(width + "-key buckets intersection") {
+        inter = map_t::template combine<set_op::overlap>(lhs, rhs);
+    }
+    map_t diff = lhs;
+    BENCHMARK(width + "-key buckets in-place difference") {
+        diff.template combine_with<set_op::subtract>(rhs);
+    }
+    long sum = 0;
+    BENCHMARK(width + "-key buckets iteration") {
+        for (auto const& [k, v] : uni) sum += v;
+    }
+    std::size_t covered = 0;
+    BENCHMARK(width + "-key buckets nodes") {
+        for (auto const& [b, n] : uni.nodes()) covered += static_cast<std::size_t>(mask_popcount(n.mask()));
+    }
+    CHECK(sum > 0);
+    CHECK(covered == uni.size());
+    CHECK(inter.size() + diff.size() == lhs.size());
+}
+
+TEST_CASE("bucket width benchmark") {
+    bench_bucket_width<std::uint64_t>("64");
+    bench_bucket_width<wide_mask<256>>("256");
+    bench_bucket_width<wide_mask<512>>("512");
+}
+
+/// @brief Random inserts and lookups over a bucket_map of the given number of 64-key buckets.
+static void bench_bucket_random_access(std::size_t buckets)
+{
+    constexpr std::size_t ops = 20000;
+    const auto keys = static_cast<std::uint32_t>(buckets * 64);
+
+    bucket_map<std::size_t, int> map;
+    map.insert_or_assign(keys - 1, 1);
+    test_rng rng(1);
+    BENCHMARK(std::to_string(buckets) + " buckets random insert") {
+        for (std::size_t i = 0; i < ops; ++i)
+            map.insert_or_assign(rng.below(keys), static_cast<int>(1 + rng.below(100)));
+    }
+    std::size_t found = 0;
+    BENCHMARK(std::to_string(buckets) + " buckets random lookup") {
+        for (std::size_t i = 0; i < ops; ++i)
+            found += map.contains(rng.below(keys));
+    }
+    CHECK(found > 0);
+}
+
+TEST_CASE("bucket_map random access benchmark") {
+    bench_bucket_random_access(1000);
+    bench_bucket_random_access(10000);
+    bench_bucket_random_access(100000);
+}
+
+/// @brief Scatter small boxes across a world of the given extent.
+static layered_map<int> make_scattered_boxes(std::uint32_t extent,
+                                             std::uint32_t count,
+                                             std::uint32_t seed,
+                                             int value = 1)
+{
+    layered_map<int> map;
+    for (GlobalPosition lo : random_positions(count, extent - 8, seed))
+        for (GlobalPosition p : GlobalAabb{lo, lo + GlobalPosition{8, 8, 8}})
+            map[p] = value;
+    return map;
+}
+
+TEST_CASE("layered_map large world benchmark") {
+    constexpr std::uint32_t extent = 100000;
+    auto lhs = make_scattered_boxes(extent, 32, 1);
+    auto rhs = make_scattered_boxes(extent, 32, 2);
+    // Every box lands on its own voxels, so aliasing would shrink the map.
+    for (auto const& [gp, v] : lhs) rhs[gp] = 2;
+
+    std::size_t visited = 0;
+    bool ordered = true;
+    BENCHMARK("ordered iteration 100k world") {
+        std::uint64_t prev = 0;
+        for (auto const& [gp, v] : lhs) {
+            ordered = ordered && (visited == 0 || prev < gp.encode());
+            prev = gp.encode();
+            ++visited;
+        }
+    }
+
+    layered_map<int> uni;
+    BENCHMARK("union 100k world") {
+        uni = lhs | rhs;
+    }
+
+    layered_map<int> inter;
+    BENCHMARK("intersection 100k world") {
+        inter = lhs & rhs;
+    }
+
+    CHECK(ordered);
+    CHECK(visited == lhs.size());
+    CHECK(lhs.size() == 32 * 512);
+    CHECK(inter.size() == lhs.size());
+    CHECK(uni.size() == rhs.size());
+}
+
+/// @brief Generate pseudo random voxels inside a cube of the given extent.
+static std::vector<std::pair<GlobalPosition, int>> random_points(std::size_t n,
+                                                                 std::uint32_t extent)
+{
+    std::vector<std::pair<GlobalPosition, int>> points;
+    points.reserve(n);
+    for (GlobalPosition p : random_positions(n, extent, 3)) points.push_back({p, 1});
+    return points;
+}
+
+TEST_CASE("chunk_map bulk import benchmark") {
+    auto points = random_points(1 << 20, 256);
+
+    chunk_map<int> scalar;
+    BENCHMARK("import 1M points one at a time") {
+        for (auto const& [gp, v] : points) scalar.insert({gp, v});
+    }
+
+    chunk_map<int> bulk;
+    BENCHMARK("import 1M points insert_range") {
+        bulk.insert_range(points);
+    }
+
+    CHECK(bulk.size() == scalar.size());
+}
+
+TEST_CASE("layered_map bulk import benchmark") {
+    auto points = random_points(1 << 15, 256);
+
+    layered_map<int> scalar;
+    BENCHMARK("import 32k points one at a time") {
+        for (auto const& [gp, v] : points) scalar.insert({gp, v});
+    }
+
+    layered_map<int> bulk;
+    BENCHMARK("import 32k points insert_range") {
+        bulk.insert_range(points);
+    }
+
+    CHECK(bulk.size() == scalar.size());
+}
+
+/// @brief Reference inset resolving every neighbour with a full lookup.
+static layered_map<int> inset_by_lookup(layered_map<int> const& map)
+{
+    layered_map<int> out;
+    for (auto const& [gp, val] : map) {
+        bool all = true;
+        for (auto [dx, dy, dz] : cardinal_offsets) {
+            GlobalPosition n;
+            if (!offset(gp, dx, dy, dz, n) || map.find(n) == map.cend()) { all = false; break; }
+        }
+        if (all) out[gp] = val;
+    }
+    return out;
+}
+
+TEST_CASE("neighbourhood stencil benchmark") {
+    auto box = make_box({1,1,1}, {41,41,41});
+
+    layered_map<int> by_lookup;
+    BENCHMARK("inset with per-neighbour lookups") {
+        by_lookup = inset_by_lookup(box);
+    }
+    layered_map<int> inner;
+    BENCHMARK("inset with neighbourhood accessor") {
+        inner = inset(box);
+    }
+    layered_map<int> grown;
+    BENCHMARK("extrude with neighbourhood accessor") {
+        grown = extrude(inner);
+    }
+
+    CHECK(std::ranges::equal(inner, by_lookup));
+    CHECK(inner.size() == 38u * 38u * 38u);
+    CHECK(grown.size() == 38u * 38u * 38u + 6u * 38u * 38u);
+}
+
+/// @brief Time insert, iterate and csg on two overlapping boxes with Edge^3 chunks.
+template<std::uint32_t Edge>
+static void chunk_edge_benchmark()
+{
+    using map_t = layered_map<int, Edge>;
+    GlobalAabb lo_box{{0,0,0}, {24,24,24}};
+    GlobalAabb hi_box{{12,12,12}, {36,36,36}};
+
+    map_t lhs;
+    map_t rhs;
+    BENCHMARK("insert") {
+        for (GlobalPosition p : lo_box) lhs[p] = 1;
+        for (GlobalPosition p : hi_box) rhs[p] = 2;
+    }
+    std::size_t visited = 0;
+    BENCHMARK("iterate") {
+        for (auto const& e : lhs) visited += static_cast<std::size_t>(e.second);
+    }
+    map_t uni;
+    map_t inter;
+    map_t diff;
+    BENCHMARK("csg") {
+        uni = lhs | rhs;
+        inter = lhs & rhs;
+        diff = lhs - rhs;
+    }
+
+    CHECK(visited == 24u * 24u * 24u);
+    CHECK(inter.size() == 12u * 12u * 12u);
+    CHECK(uni.size() == 2u * 24u * 24u * 24u - inter.size());
+    CHECK(diff.size() == 24u * 24u * 24u - inter.size());
+}
+
+TEST_CASE("chunk edge benchmark matrix") {
+    SUBCASE("edge 8")  { chunk_edge_benchmark<8>(); }
+    SUBCASE("edge 16") { chunk_edge_benchmark<16>(); }
+    SUBCASE("edge 32") { chunk_edge_benchmark<32>(); }
+    SUBCASE("edge 64") { chunk_edge_benchmark<64>(); }
+}
+
+TEST_CASE("sorted bulk assign benchmark") {
+    auto lhs = make_box({0,0,0}, {40,40,40});
+    auto rhs = make_box({20,20,20}, {60,60,60}, 2);
+    std::vector<std::pair<GlobalPosition, int>> merged;
+    for (auto const& e : layered_map<int>::merge(lhs, rhs)) merged.emplace_back(e.first, e.second);
+    std::vector<std::pair<GlobalPosition, int>> shuffled(merged.rbegin(), merged.rend());
+
+    layered_map<int> per_element;
+    BENCHMARK("per element operator[]") {
+        for (auto const& [gp, v] : merged) per_element[gp] = v;
+    }
+    layered_map<int> sorted;
+    BENCHMARK("assign_sorted on sorted input") {
+        sorted.assign_sorted(merged);
+    }
+    layered_map<int> unsorted;
+    BENCHMARK("assign_sorted on reversed input") {
+        unsorted.assign_sorted(shuffled);
+    }
+
+    CHECK(std::ranges::equal(per_element, sorted));
+    CHECK(std::ranges::equal(unsorted, sorted));
+}
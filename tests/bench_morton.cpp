@@ -0,0 +1,120 @@
+#include "doctest.h"
+#include "positions.h"
+#include "benchmark.h"
+#include "test_random.h"
+#include <vector>
+
+/// @brief Bit-by-bit reference encoder the kernels replaced.
+static std::uint64_t loop_encode64(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+    std::uint64_t out = 0;
+    for (unsigned bit = 0; bit < 21; ++bit) {
+        out |= std::uint64_t((x >> bit) & 1u) << (3 * bit);
+        out |= std::uint64_t((y >> bit) & 1u) << (3 * bit + 1);
+        out |= std::uint64_t((z >> bit) & 1u) << (3 * bit + 2);
+    }
+    return out;
+}
+
+/// @brief Bit-by-bit reference decoder the kernels replaced.
+static std::array<std::uint32_t, 3> loop_decode64(std::uint64_t code)
+{
+    std::array<std::uint32_t, 3> p{0,0,0};
+    for (unsigned bit = 0; bit < 21; ++bit) {
+        p[0] |= std::uint32_t((code >> (3 * bit)) & 1u) << bit;
+        p[1] |= std::uint32_t((code >> (3 * bit + 1)) & 1u) << bit;
+        p[2] |= std::uint32_t((code >> (3 * bit + 2)) & 1u) << bit;
+    }
+    return p;
+}
+
+TEST_CASE("morton encode benchmark") {
+    auto pts = random_positions(1 << 20, 1u << 21, 42);
+
+    std::uint64_t loop_sum = 0;
+    BENCHMARK("encode64 loop") {
+        for (auto p : pts) loop_sum += loop_encode64(p.x, p.y, p.z);
+    }
+
+    std::uint64_t magic_sum = 0;
+    BENCHMARK("encode64 magic bits") {
+        for (auto p : pts) magic_sum += morton::encode64_magic(p.x, p.y, p.z);
+    }
+
+    std::uint64_t dispatch_sum = 0;
+    BENCHMARK("encode64 dispatched") {
+        for (auto p : pts) dispatch_sum += morton_encode64(p.x, p.y, p.z);
+    }
+
+#if defined(MORTON_BMI2_STATIC) || defined(MORTON_BMI2_DISPATCH)
+    if (morton::bmi2_available) {
+        std::uint64_t bmi2_sum = 0;
+        BENCHMARK("encode64 bmi2 pdep") {
+            for (auto p : pts) bmi2_sum += morton::encode64_bmi2(p.x, p.y, p.z);
+        }
+        CHECK(bmi2_sum == loop_sum);
+    }
+#endif
+
+    CHECK(magic_sum == loop_sum);
+    CHECK(dispatch_sum == loop_sum);
+}
+
+TEST_CASE("morton decode benchmark") {
+    auto pts = random_positions(1 << 20, 1u << 21, 42);
+    std::vector<std::uint64_t> codes;
+    codes.reserve(pts.size());
+    for (auto p : pts) codes.push_back(morton::encode64_magic(p.x, p.y, p.z));
+
+    std::uint64_t loop_sum = 0;
+    BENCHMARK("decode64 loop") {
+        for (auto c : codes) { auto d = loop_decode64(c); loop_sum += d[0] ^ d[1] ^ d[2]; }
+    }
+
+    std::uint64_t magic_sum = 0;
+    BENCHMARK("decode64 magic bits") {
+        for (auto c : codes) { auto d = morton::decode64_magic(c); magic_sum += d[0] ^ d[1] ^ d[2]; }
+    }
+
+    std::uint64_t dispatch_sum = 0;
+    BENCHMARK("decode64 dispatched") {
+        for (auto c : codes) { auto d = morton_decode64(c); dispatch_sum += d[0] ^ d[1] ^ d[2]; }
+    }
+
+    CHECK(magic_sum == loop_sum);
+    CHECK(dispatch_sum == loop_sum);
+}
+
+TEST_CASE("local position encode benchmark") {
+    auto pts = random_positions(1 << 20, 32, 42);
+
+    std::uint64_t loop_sum = 0;
+    BENCHMARK("local encode loop") {
+        for (auto p : pts) loop_sum += loop_encode64(p.x, p.y, p.z);
+    }
+
+    std::uint64_t magic_sum = 0;
+    BENCHMARK("local encode magic bits") {
+        for (auto p : pts) magic_sum += morton::encode32_magic(p.x, p.y, p.z);
+    }
+
+    std::uint64_t table_sum = 0;
+    BENCHMARK("local encode table") {
+        for (auto p : pts) table_sum += morton::encode_local(p.x, p.y, p.z);
+    }
+
+    std::uint64_t decode_sum = 0;
+    BENCHMARK("local decode table") {
+        for (auto p : pts) {
+            auto d = morton::decode_local(morton::encode_local(p.x, p.y, p.z));
+            decode_sum += d[0] + d[1] + d[2];
+        }
+    }
+
+    std::uint64_t expected = 0;
+    for (auto p : pts) expected += p.x + p.y + p.z;
+
+    CHECK(magic_sum == loop_sum);
+    CHECK(table_sum == loop_sum);
+    CHECK(decode_sum == expected);
+}
@@ -1,7 +1,13 @@
 #include "doctest.h"
 #include "array_packed.h"
+#include "test_random.h"
 #include <vector>
 #include <ranges>
+#include <array>
+#include <cstdint>
+#include <bitset>
+#include <limits>
+#include <stdexcept>
 
 namespace checks {
     using arr_t = array_packed<64, int>;
@@ -40,3 +46,172 @@ TEST_CASE("iterate values") {
     CHECK(out[2] == 4);
     CHECK(out[3] == 6);
 }
+
+TEST_CASE("transpose8 swaps rows and columns") {
+    std::uint64_t x = 0;
+    for (int r = 0; r < 8; ++r) x |= std::uint64_t{1u << r} << (8 * r);
+    CHECK(packed_bits::transpose8(x) == x);
+    const std::uint64_t row0 = 0xb5;
+    const std::uint64_t t = packed_bits::transpose8(row0);
+    for (int c = 0; c < 8; ++c) CHECK(((t >> (8 * c)) & 0xff) == ((row0 >> c) & 1u));
+}
+
+TEST_CASE_TEMPLATE("load_all and store_all match per-element access", Arr,
+                   array_packed<64, int>, array_packed<5, int>, array_packed<100, std::uint8_t>,
+                   array_packed<256, std::int64_t>, array_packed<512, std::uint16_t>) {
+    using T = typename Arr::value_type;
+    constexpr std::size_t n = Arr::size();
+    std::array<T, n> values{};
+    test_rng rng(12345);
+    for (std::size_t i = 0; i < n; ++i) values[i] = static_cast<T>(i % 3 ? rng.next() >> 40 : 0);
+    if constexpr (std::is_signed_v<T>) values[n / 2] = -7;
+
+    Arr bulk;
+    bulk.store_all(values);
+    Arr single;
+    for (std::size_t i = 0; i < n; ++i) single[i] = values[i];
+    CHECK(bulk.planes() == single.planes());
+    for (std::size_t i = 0; i < n; ++i) CHECK(bulk[i] == values[i]);
+    CHECK(single.load_all() == values);
+
+    bulk.store_all(std::array<T, n>{});
+    CHECK(bulk.planes() == 0u);
+    CHECK(bulk.load_all() == std::array<T, n>{});
+}
+
+TEST_CASE_TEMPLATE("bit-sliced queries match a lane scan", T, int, std::uint8_t, std::int64_t) {
+    constexpr std::size_t n = 100;
+    std::array<T, n> values{};
+    for (std::size_t i = 0; i < n; ++i) values[i] = static_cast<T>(i * 7 % 23);
+    array_packed<n, T> arr;
+    arr.store_all(values);
+
+    std::vector<T> probes{0, 1, 5, 22, 23, 100, std::numeric_limits<T>::max()};
+    if constexpr (std::is_signed_v<T>) probes.push_back(-3);
+    auto check = [&] {
+        for (T v : probes) {
+            std::bitset<n> eq;
+            std::bitset<n> lt;
+            for (std::size_t i = 0; i < n; ++i) {
+                eq[i] = values[i] == v;
+                lt[i] = values[i] < v;
+            }
+            CHECK((arr.find_equal(v) == eq));
+            CHECK(arr.count_equal(v) == eq.count());
+            CHECK((arr.less_than(v) == lt));
+        }
+    };
+    check();
+    if constexpr (std::is_signed_v<T>) {
+        // Negative lanes store the sign plane.
+        values[3] = -3;
+        values[50] = std::numeric_limits<T>::min();
+        arr.store_all(values);
+        check();
+    }
+}
+
+TEST_CASE("planes shrink when the widest value is overwritten") {
+    array_packed<64, int> a;
+    a[3] = 1000;
+    a[4] = 5;
+    CHECK(a.planes() == 10u);
+    a[3] = 0;
+    CHECK(a.planes() == 3u);
+    a[4] = 0;
+    CHECK(a.planes() == 0u);
+    CHECK(a.load_all() == std::array<int, 64>{});
+}
+
+TEST_CASE("zigzag keeps small signed values narrow") {
+    array_packed<64, int> plain;
+    array_packed<64, int, zigzag_encoding> zigzag;
+    std::array<int, 64> values{};
+    for (int i = 0; i < 64; ++i) values[i] = i % 7 - 3;
+    plain.store_all(values);
+    zigzag.store_all(values);
+    CHECK(plain.planes() == 32u);
+    CHECK(zigzag.planes() == 3u);
+    CHECK(zigzag.load_all() == values);
+    zigzag[10] = -100;
+    CHECK(zigzag[10] == -100);
+    CHECK(zigzag.planes() == 8u);
+    zigzag[10] = 1;
+    CHECK(zigzag.planes() == 3u);
+
+    for (int v : {-4, -3, -1, 0, 1, 3, 4, std::numeric_limits<int>::min()}) {
+        std::size_t less = 0;
+        std::size_t equal = 0;
+        for (int i = 0; i < 64; ++i) {
+            less += zigzag[i] < v;
+            equal += zigzag[i] == v;
+        }
+        CHECK(zigzag.less_than(v).count() == less);
+        CHECK(zigzag.count_equal(v) == equal);
+    }
+    zigzag[0] = std::numeric_limits<int>::min();
+    zigzag[1] = std::numeric_limits<int>::max();
+    CHECK(zigzag[0] == std::numeric_limits<int>::min());
+    CHECK(zigzag[1] == std::numeric_limits<int>::max());
+}
+
+TEST_CASE("frame of reference stores offsets from the smallest value") {
+    array_packed<64, int, frame_of_reference_encoding> heights;
+    std::array<int, 64> values{};
+    for (int i = 0; i < 64; ++i) values[i] = 1000 + i % 10;
+    heights.store_all(values);
+    CHECK(heights.planes() == 4u);
+    CHECK(heights.load_all() == values);
+    CHECK(heights.count_equal(1003) == 7u);
+    CHECK(heights.count_equal(3) == 0u);
+    CHECK(heights.less_than(1002).count() == 14u);
+    CHECK(heights.less_than(1000).none());
+
+    // Writing below the base refits the array.
+    heights[5] = 990;
+    CHECK(heights[5] == 990);
+    CHECK(heights[6] == 1006);
+    CHECK(heights.planes() == 5u);
+    CHECK(heights.less_than(1000).count() == 1u);
+
+    array_packed<64, int, frame_of_reference_encoding> fresh;
+    fresh[2] = -5;
+    CHECK(fresh[2] == -5);
+    CHECK(fresh[3] == 0);
+    CHECK(fresh.planes() == 3u);
+}
+
+TEST_CASE_TEMPLATE("plane storage variants behave alike", Storage,
+                   heap_planes, fixed_planes<>, small_planes<2>) {
+    using arr_t = array_packed<64, int, plain_encoding, Storage>;
+    std::array<int, 64> values{};
+    for (int i = 0; i < 64; ++i) values[i] = i % 4;
+    arr_t a;
+    a.store_all(values);
+    CHECK(a.planes() == 2u);
+    a[9] = 1 << 12;
+    CHECK(a.planes() == 13u);
+    CHECK(a[9] == 1 << 12);
+    CHECK(a[10] == 2);
+    arr_t copy = a;
+    a[9] = 1;
+    CHECK(a.planes() == 2u);
+    CHECK(a[10] == 2);
+    CHECK(copy[9] == 1 << 12);
+    a[3] = -1;
+    CHECK(a.planes() == 32u);
+    CHECK(a[3] == -1);
+    a[3] = 3;
+    values[9] = 1;
+    CHECK(a.load_all() == values);
+    CHECK(a.count_equal(3) == 16u);
+}
+
+TEST_CASE("fixed plane storage rejects values wider than its capacity") {
+    array_packed<64, int, plain_encoding, fixed_planes<4>> a;
+    a[0] = 15;
+    CHECK(a.planes() == 4u);
+    CHECK_THROWS_AS(a[1] = 16, std::length_error);
+    static_assert(sizeof(array_packed<64, std::uint8_t, plain_encoding, fixed_planes<>>)
+                  <= 8 * sizeof(std::bitset<64>) + sizeof(std::size_t));
+}
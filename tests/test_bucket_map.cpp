@@ -3,6 +3,27 @@
 #include <string>
 #include <vector>
 #include <ranges>
+#include <algorithm>
+
+/// @brief Value whose hashes all collide, to exercise the index fallback.
+struct colliding {
+    int v{};
+    bool operator==(const colliding&) const = default;
+};
+template<> struct std::hash<colliding> {
+    std::size_t operator()(const colliding&) const noexcept { return 7; }
+};
+
+/// @brief Copy the key/value pairs of a map or view into a vector.
+template<typename Range>
+static auto as_pairs(Range&& range)
+{
+    using value_t = std::ranges::range_value_t<Range>;
+    std::vector<std::pair<std::remove_cvref_t<typename value_t::first_type>,
+                          std::remove_cvref_t<typename value_t::second_type>>> out;
+    for (auto const& [k, v] : range) out.emplace_back(k, v);
+    return out;
+}
 
 namespace checks {
     using map_t   = bucket_map<std::size_t, std::string>;
@@ -19,6 +40,10 @@ namespace checks {
                                std::pair<const std::size_t, const std::string&>>);
     static_assert(std::same_as<std::ranges::range_value_t<view_t>,
                                std::pair<const std::size_t, node_t>>);
+    // Wide-bucket iterators read the planes in place instead of keeping a decoded copy.
+    using wide_t = bucket_map<std::size_t, int, wide_mask<512>>;
+    static_assert(sizeof(wide_t::const_iterator) <= 2 * sizeof(wide_mask<512>));
+    static_assert(sizeof(wide_t::nodes_view::const_iterator) <= 4 * sizeof(wide_mask<512>));
 }
 
 TEST_CASE("insert and size") {
@@ -189,3 +214,347 @@ TEST_CASE("optimized exclusive view") {
     CHECK(sym == expected);
 }
 
+
+TEST_CASE("assign_sorted writes runs per bucket") {
+    bucket_map<std::size_t, std::string> map;
+    map.insert_or_assign(3, "keep");
+    map.insert_or_assign(70, "old");
+    std::vector<std::pair<std::size_t, std::string>> run{
+        {1, "a"}, {2, "a"}, {63, "b"}, {64, "c"}, {70, "a"}, {200, "b"}, {5, "late"}
+    };
+    map.assign_sorted(run);
+
+    bucket_map<std::size_t, std::string> ref;
+    ref.insert_or_assign(3, "keep");
+    ref.insert_or_assign(70, "old");
+    for (auto const& [k, v] : run) ref.insert_or_assign(k, v);
+
+    CHECK(map.size() == ref.size());
+    CHECK(std::ranges::equal(map, ref));
+    CHECK(map.at(70) == "a");
+    CHECK(map.at(5) == "late");
+    auto nodes = map.nodes();
+    CHECK(std::distance(nodes.begin(), nodes.end()) == std::distance(ref.nodes().begin(), ref.nodes().end()));
+}
+
+TEST_CASE("combine matches the lazy set views") {
+    using map_t = bucket_map<std::size_t, std::string>;
+    map_t lhs;
+    map_t rhs;
+    for (std::size_t k = 0; k < 150; k += 3) lhs.insert_or_assign(k, k % 2 ? "odd" : "even");
+    for (std::size_t k = 60; k < 260; k += 5) rhs.insert_or_assign(k, k % 2 ? "odd" : "rhs");
+    rhs.insert_or_assign(1000, "far");
+
+    auto uni = map_t::combine<set_op::merge>(lhs, rhs);
+    auto inter = map_t::combine<set_op::overlap>(lhs, rhs);
+    auto diff = map_t::combine<set_op::subtract>(lhs, rhs);
+    auto sym = map_t::combine<set_op::exclusive>(lhs, rhs);
+    CHECK(as_pairs(uni) == as_pairs(map_t::merge(lhs, rhs)));
+    CHECK(as_pairs(inter) == as_pairs(map_t::overlap(lhs, rhs)));
+    CHECK(as_pairs(diff) == as_pairs(map_t::subtract(lhs, rhs)));
+    CHECK(as_pairs(sym) == as_pairs(map_t::exclusive(lhs, rhs)));
+    CHECK(uni.size() == as_pairs(uni).size());
+    CHECK(inter.size() == as_pairs(inter).size());
+
+    // "odd" from both sides shares one node per bucket after the union.
+    for (auto const& [b, n] : uni.nodes()) {
+        std::size_t same = 0;
+        for (auto const& [b2, n2] : uni.nodes())
+            if (b2 == b && n2.value() == n.value()) ++same;
+        CHECK(same == 1);
+    }
+
+    map_t empty;
+    CHECK(map_t::combine<set_op::overlap>(lhs, empty).empty());
+    CHECK(as_pairs(map_t::combine<set_op::merge>(empty, rhs)) == as_pairs(rhs));
+}
+
+TEST_CASE("overlap view ends with the shorter range") {
+    bucket_map<std::size_t, int> lhs;
+    for (std::size_t k = 0; k < 20; ++k) lhs.insert_or_assign(k, 1);
+    bucket_map<std::size_t, int> rhs;
+    rhs.insert_or_assign(3, 2);
+    rhs.insert_or_assign(5, 2);
+    auto inter = std::ranges::to<std::vector<std::pair<std::size_t, int>>>(
+        lhs | bucket_map<std::size_t, int>::overlap(rhs));
+    std::vector<std::pair<std::size_t, int>> expected{{3,1},{5,1}};
+    CHECK(inter == expected);
+}
+
+TEST_CASE("combine_with matches combine") {
+    using map_t = bucket_map<std::size_t, std::string>;
+    map_t lhs;
+    map_t rhs;
+    for (std::size_t k = 0; k < 150; k += 3) lhs.insert_or_assign(k, k % 2 ? "odd" : "even");
+    for (std::size_t k = 60; k < 260; k += 5) rhs.insert_or_assign(k, k % 2 ? "odd" : "rhs");
+
+    auto check = [&]<set_op Op>() {
+        map_t inplace = lhs;
+        inplace.combine_with<Op>(rhs);
+        auto fresh = map_t::combine<Op>(lhs, rhs);
+        CHECK(as_pairs(inplace) == as_pairs(fresh));
+        CHECK(inplace.size() == fresh.size());
+        CHECK(std::ranges::distance(inplace.nodes()) == std::ranges::distance(fresh.nodes()));
+    };
+    check.operator()<set_op::merge>();
+    check.operator()<set_op::overlap>();
+    check.operator()<set_op::subtract>();
+    check.operator()<set_op::exclusive>();
+
+    map_t self = lhs;
+    self.combine_with<set_op::merge>(self);
+    CHECK(self.size() == lhs.size());
+    self.combine_with<set_op::subtract>(self);
+    CHECK(self.empty());
+}
+
+TEST_CASE("seek and lower_bound skip empty buckets") {
+    bucket_map<std::size_t, int> map;
+    for (std::size_t k : {3u, 64u, 65u, 700u}) map.insert_or_assign(k, static_cast<int>(k));
+    CHECK(map.lower_bound(0)->first == 3u);
+    CHECK(map.lower_bound(4)->first == 64u);
+    CHECK(map.lower_bound(66)->first == 700u);
+    CHECK(map.lower_bound(701) == map.end());
+    CHECK(map.lower_bound(100000) == map.end());
+
+    auto it = map.begin();
+    it.seek(65);
+    CHECK(it->first == 65u);
+    it.seek(1);
+    CHECK(it->first == 65u);
+    it.seek(100000);
+    CHECK(it == map.end());
+}
+
+TEST_CASE("n-ary views over bucket maps and vectors") {
+    using map_t = bucket_map<std::size_t, int>;
+    using pairs = std::vector<std::pair<std::size_t, int>>;
+    std::vector<map_t> maps(5);
+    for (std::size_t i = 0; i < maps.size(); ++i)
+        for (std::size_t k = i; k < 400; k += i + 1) maps[i].insert_or_assign(k, static_cast<int>(i));
+
+    pairs expected_all;
+    pairs expected_common;
+    for (std::size_t k = 0; k < 400; ++k) {
+        std::size_t hits = 0;
+        int first = -1;
+        for (std::size_t i = 0; i < maps.size(); ++i)
+            if (maps[i].contains(k)) {
+                if (first < 0) first = static_cast<int>(i);
+                ++hits;
+            }
+        if (hits) expected_all.emplace_back(k, first);
+        if (hits == maps.size()) expected_common.emplace_back(k, first);
+    }
+    CHECK(std::ranges::to<pairs>(views::merge_n(maps, key_less{})) == expected_all);
+    CHECK(std::ranges::to<pairs>(views::overlap_n(maps, key_less{})) == expected_common);
+    CHECK(!expected_common.empty());
+
+    std::vector<std::vector<int>> plain{{1, 4, 9}, {2, 4, 8, 9}, {0, 4, 9, 12}};
+    CHECK(std::ranges::to<std::vector<int>>(views::merge_n(plain)) == std::vector<int>{0, 1, 2, 4, 8, 9, 12});
+    CHECK(std::ranges::to<std::vector<int>>(views::overlap_n(plain)) == std::vector<int>{4, 9});
+}
+
+TEST_CASE("iteration skips emptied and sparse buckets") {
+    bucket_map<std::size_t, int> map;
+    std::vector<std::size_t> keys{0, 63, 64, 127, 130, 1000, 4095};
+    for (std::size_t k : keys) map.insert_or_assign(k, static_cast<int>(k % 3));
+    map.erase(64);
+    map.erase(127);
+    keys.erase(keys.begin() + 2, keys.begin() + 4);
+
+    std::vector<std::size_t> seen;
+    for (auto const& [k, v] : map) {
+        seen.push_back(k);
+        CHECK(v == static_cast<int>(k % 3));
+    }
+    CHECK(seen == keys);
+
+    auto it = map.begin();
+    auto copy = it;
+    ++it;
+    CHECK(copy->first == 0u);
+    CHECK(it->first == 63u);
+    copy = it;
+    CHECK((++copy)->first == 130u);
+    CHECK(it->first == 63u);
+}
+
+TEST_CASE_TEMPLATE("dedup policies store equal values once", Dedup, bucket_dedup, map_dedup) {
+    bucket_map<std::size_t, std::string, std::uint64_t, Dedup> map;
+    for (std::size_t k = 0; k < 640; ++k) map.insert_or_assign(k, k % 3 ? "stone" : "dirt");
+    CHECK(map.size() == 640u);
+    CHECK(map.at(3) == "dirt");
+    CHECK(map.at(4) == "stone");
+    if constexpr (std::same_as<Dedup, map_dedup>) CHECK(map.stored_values() == 2u);
+    else CHECK(map.stored_values() == 20u);
+    CHECK(std::ranges::distance(map.nodes()) == 20);
+
+    auto copy = map;
+    copy.insert_or_assign(1000, "dirt");
+    copy.insert_or_assign(1001, "sand");
+    CHECK(copy.stored_values() == map.stored_values() + (std::same_as<Dedup, map_dedup> ? 1u : 2u));
+    auto merged = decltype(map)::template combine<set_op::merge>(map, copy);
+    CHECK(merged.size() == copy.size());
+    CHECK(merged.stored_values() <= copy.stored_values());
+}
+
+TEST_CASE("map_dedup falls back to the bucket on hash collisions") {
+    bucket_map<std::size_t, colliding, std::uint64_t, map_dedup> map;
+    for (std::size_t k = 0; k < 256; ++k) map.insert_or_assign(k, colliding{static_cast<int>(k % 4)});
+    for (std::size_t k = 0; k < 256; ++k) CHECK(map.at(k).v == static_cast<int>(k % 4));
+    // One indexed value plus one copy of each colliding value per bucket.
+    CHECK(map.stored_values() == 1u + 3u * 4u);
+    for (auto const& [bucket, node] : map.nodes())
+        CHECK(std::popcount(node.mask()) == 16);
+    static_assert(std::same_as<bucket_map<std::size_t, int>::dedup_policy, map_dedup>);
+}
+
+TEST_CASE_TEMPLATE("compact releases overwritten values", Dedup, bucket_dedup, map_dedup) {
+    using map_t = bucket_map<std::size_t, std::string, std::uint64_t, Dedup>;
+    using pairs = std::vector<std::pair<std::size_t, std::string>>;
+    map_t map;
+    for (int round = 0; round < 50; ++round)
+        for (std::size_t k = 0; k < 200; k += 7) {
+            std::string v = "v";
+            v += std::to_string(round * 1000 + k);
+            map.insert_or_assign(k, std::move(v));
+        }
+    for (std::size_t k = 0; k < 200; k += 7) map.insert_or_assign(k, k % 2 ? "odd" : "even");
+    map.insert_or_assign(5000, "far");
+    map.erase(5000);
+    const auto before = std::ranges::to<pairs>(map);
+    CHECK(map.stored_values() > 1000u);
+
+    CHECK(map.compact() >= 1000u);
+    CHECK(map.stored_values() == (std::same_as<Dedup, map_dedup> ? 2u : 7u));
+    CHECK(std::ranges::to<pairs>(map) == before);
+    CHECK(map.lower_bound(197) == map.end());
+    CHECK(map.compact() == 0u);
+
+    map.insert_or_assign(3, "even");
+    map.insert_or_assign(4, "new");
+    CHECK(map.at(3) == "even");
+    CHECK(map.at(4) == "new");
+    CHECK(map.stored_values() == (std::same_as<Dedup, map_dedup> ? 3u : 8u));
+
+    map_t empty;
+    CHECK(empty.compact() == 0u);
+    CHECK(empty.empty());
+}
+
+TEST_CASE("nodes group keys by value within each bucket") {
+    bucket_map<std::size_t, int, std::uint64_t, bucket_dedup> map;
+    for (std::size_t k = 0; k < 300; ++k)
+        if (k % 5 != 0) map.insert_or_assign(k, static_cast<int>((k * k) % 11));
+    map.erase(130);
+
+    std::size_t covered = 0;
+    std::size_t last_bucket = 0;
+    for (auto const& [bucket, n] : map.nodes()) {
+        CHECK(bucket >= last_bucket);
+        last_bucket = bucket;
+        CHECK(n.bucket_index() == bucket);
+        REQUIRE(n.mask() != 0u);
+        for (std::size_t k : n.occupied()) {
+            CHECK(k / 64 == bucket);
+            CHECK(map.at(k) == n.value());
+            ++covered;
+        }
+        for (auto const& [b2, n2] : map.nodes())
+            if (b2 == bucket && n2.mask() != n.mask()) {
+                CHECK((n2.mask() & n.mask()) == 0u);
+                CHECK(n2.value() != n.value());
+            }
+    }
+    CHECK(covered == map.size());
+
+    auto it = map.nodes().begin();
+    auto copy = it;
+    ++it;
+    CHECK(copy != it);
+    CHECK(copy->second.mask() != it->second.mask());
+}
+
+TEST_CASE("copy, move and swap keep contents") {
+    using map_t = bucket_map<std::size_t, std::string>;
+    using pairs = std::vector<std::pair<std::size_t, std::string>>;
+    static_assert(std::is_nothrow_move_constructible_v<map_t>);
+    static_assert(std::is_nothrow_move_assignable_v<map_t>);
+    static_assert(std::is_nothrow_swappable_v<map_t>);
+    static_assert(std::is_copy_assignable_v<map_t>);
+
+    map_t a;
+    for (std::size_t k = 0; k < 500; k += 3) a.insert_or_assign(k, k % 4 ? "rock" : "ore");
+    const auto expected = std::ranges::to<pairs>(a);
+
+    map_t copy(a);
+    CHECK(std::ranges::to<pairs>(copy) == expected);
+    copy.insert_or_assign(1, "gem");
+    CHECK(!a.contains(1));
+
+    map_t moved(std::move(copy));
+    CHECK(moved.contains(1));
+    CHECK(copy.empty());
+    CHECK(copy.stored_values() == 0u);
+    copy.insert_or_assign(7, "ore");
+    CHECK(copy.at(7) == "ore");
+    CHECK(copy.size() == 1u);
+
+    map_t assigned;
+    assigned = a;
+    CHECK(std::ranges::to<pairs>(assigned) == expected);
+    assigned = std::move(moved);
+    CHECK(assigned.at(1) == "gem");
+    CHECK(moved.empty());
+
+    swap(assigned, copy);
+    CHECK(assigned.size() == 1u);
+    CHECK(copy.at(1) == "gem");
+    copy.clear();
+    CHECK(copy.begin() == copy.end());
+    copy.insert_or_assign(3, "x");
+    CHECK(copy.at(3) == "x");
+
+    map_t fresh;
+    CHECK(fresh.begin() == fresh.end());
+    CHECK(fresh.compact() == 0u);
+    CHECK(std::ranges::distance(fresh.nodes()) == 0);
+}
+
+TEST_CASE_TEMPLATE("wide buckets match 64-key buckets", Bucket, wide_mask<256>, wide_mask<512>) {
+    using narrow_t = bucket_map<std::size_t, int>;
+    using wide_t = bucket_map<std::size_t, int, Bucket>;
+    narrow_t nl, nr;
+    wide_t wl, wr;
+    for (std::size_t k = 0; k < 3000; k += 7) { nl.insert_or_assign(k, int(k % 5)); wl.insert_or_assign(k, int(k % 5)); }
+    for (std::size_t k = 500; k < 5000; k += 11) { nr.insert_or_assign(k, int(k % 3)); wr.insert_or_assign(k, int(k % 3)); }
+    nl.erase(511); wl.erase(511);
+    CHECK(as_pairs(wl) == as_pairs(nl));
+    CHECK(wl.size() == nl.size());
+    CHECK(wl.lower_bound(1000)->first == nl.lower_bound(1000)->first);
+    CHECK(wr.lower_bound(5000) == wr.end());
+
+    auto check = [&]<set_op Op>() {
+        auto fresh = wide_t::template combine<Op>(wl, wr);
+        CHECK(as_pairs(fresh) == as_pairs(narrow_t::combine<Op>(nl, nr)));
+        wide_t inplace = wl;
+        inplace.template combine_with<Op>(wr);
+        CHECK(as_pairs(inplace) == as_pairs(fresh));
+        CHECK(inplace.size() == fresh.size());
+    };
+    check.template operator()<set_op::merge>();
+    check.template operator()<set_op::overlap>();
+    check.template operator()<set_op::subtract>();
+    check.template operator()<set_op::exclusive>();
+
+    std::size_t keys = 0;
+    for (auto const& [b, n] : wl.nodes()) {
+        for (std::size_t k : n.occupied()) {
+            CHECK(k / mask_traits<Bucket>::bits == b);
+            CHECK(wl.at(k) == n.value());
+        }
+        keys += static_cast<std::size_t>(mask_popcount(n.mask()));
+    }
+    CHECK(keys == wl.size());
+}
@@ -0,0 +1,186 @@
+#include "doctest.h"
+#include "chunk_hash_map.h"
+#include "layered_map.h"
+#include "aabb.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <ranges>
+
+namespace checks {
+    using map_t   = chunk_hash_map<ChunkKey, std::string>;
+    using iter_t  = map_t::iterator;
+    using citer_t = map_t::const_iterator;
+
+    static_assert(std::forward_iterator<iter_t>);
+    static_assert(std::forward_iterator<citer_t>);
+    static_assert(std::sentinel_for<iter_t, iter_t>);
+    static_assert(std::ranges::forward_range<map_t>);
+    static_assert(std::ranges::common_range<map_t>);
+    static_assert(std::same_as<std::ranges::range_value_t<map_t>,
+                               std::pair<const ChunkKey, std::string>>);
+    static_assert(std::forward_iterator<hashed_layered_map<int>::const_iterator>);
+}
+
+TEST_CASE("chunk_hash_map insert find erase") {
+    chunk_hash_map<ChunkKey, int> map;
+    std::map<ChunkKey, int> ref;
+    for (std::uint32_t i = 0; i < 500; ++i) {
+        ChunkPosition c{i % 13, i % 7, i / 3};
+        map[c] = static_cast<int>(i);
+        ref[c] = static_cast<int>(i);
+    }
+    CHECK(map.size() == ref.size());
+    for (std::uint32_t i = 0; i < 500; i += 3)
+        CHECK(map.erase(ChunkPosition{i % 13, i % 7, i / 3}) == ref.erase(ChunkPosition{i % 13, i % 7, i / 3}));
+    CHECK(map.size() == ref.size());
+    for (auto const& [k, v] : ref) {
+        REQUIRE(map.find(k) != map.end());
+        CHECK(map.find(k)->second == v);
+    }
+    CHECK(map.find(ChunkPosition{99, 99, 99}) == map.end());
+    CHECK_THROWS_AS(map.at(ChunkPosition{99, 99, 99}), std::out_of_range);
+}
+
+TEST_CASE("chunk_hash_map emplacing an existing key does not rehash") {
+    chunk_hash_map<ChunkKey, int> map;
+    for (std::uint32_t i = 0; i < 12; ++i) map[ChunkPosition{i, 0, 0}] = static_cast<int>(i);
+    REQUIRE(map.capacity() == 16);
+    auto before = map.find(ChunkPosition{3, 0, 0});
+    auto [it, inserted] = map.try_emplace(ChunkPosition{3, 0, 0}, 99);
+    CHECK_FALSE(inserted);
+    CHECK(map.capacity() == 16);
+    CHECK(it == before);
+    CHECK(it->second == 3);
+}
+
+TEST_CASE("chunk_hash_map iterates in morton order") {
+    chunk_hash_map<ChunkKey, int> map;
+    std::map<ChunkKey, int> ref;
+    for (std::uint32_t i = 0; i < 200; ++i) {
+        ChunkPosition c{(i * 7919u) % 64, (i * 104729u) % 64, i % 5};
+        map.try_emplace(c, static_cast<int>(i));
+        ref.try_emplace(c, static_cast<int>(i));
+    }
+    CHECK(std::ranges::equal(map, ref));
+
+    auto it = map.erase(map.begin());
+    ref.erase(ref.begin());
+    CHECK(it == map.begin());
+    CHECK(std::ranges::equal(map, ref));
+}
+
+TEST_CASE("chunk_hash_map erase while iterating keeps morton order") {
+    chunk_hash_map<ChunkKey, int> map;
+    std::map<ChunkKey, int> ref;
+    for (std::uint32_t i = 0; i < 2000; ++i) {
+        ChunkPosition c{(i * 7919u) % 61, (i * 104729u) % 53, i % 9};
+        map.try_emplace(c, static_cast<int>(i));
+        ref.try_emplace(c, static_cast<int>(i));
+    }
+    for (auto it = map.begin(); it != map.end();) {
+        if (it->second % 3 != 0) it = map.erase(it);
+        else ++it;
+    }
+    std::erase_if(ref, [](auto const& e) { return e.second % 3 != 0; });
+    CHECK(std::ranges::equal(map, ref));
+
+    while (map.size() > 5) map.erase(map.begin());
+    while (ref.size() > 5) ref.erase(ref.begin());
+    CHECK(std::ranges::equal(map, ref));
+    map.try_emplace(ChunkPosition{0, 0, 0}, -1);
+    ref.try_emplace(ChunkPosition{0, 0, 0}, -1);
+    CHECK(std::ranges::equal(map, ref));
+}
+
+TEST_CASE("chunk_hash_map lower_bound matches std::map") {
+    chunk_hash_map<ChunkKey, int> map;
+    std::map<ChunkKey, int> ref;
+    for (std::uint32_t i = 0; i < 300; ++i) {
+        ChunkPosition c{(i * 7919u) % 40, (i * 104729u) % 40, i % 7};
+        map.try_emplace(c, static_cast<int>(i));
+        ref.try_emplace(c, static_cast<int>(i));
+    }
+    auto check = [&] {
+        for (std::uint32_t x = 0; x < 48; x += 3)
+            for (std::uint32_t y = 0; y < 48; y += 5) {
+                ChunkKey key{ChunkPosition{x, y, x % 8}};
+                auto it = map.lower_bound(key);
+                auto expected = ref.lower_bound(key);
+                REQUIRE((it == map.end()) == (expected == ref.end()));
+                if (it != map.end()) CHECK(it->first == expected->first);
+            }
+    };
+    check();
+    for (auto it = map.begin(); it != map.end();) {
+        if (it->second % 4 != 0) it = map.erase(it);
+        else ++it;
+    }
+    std::erase_if(ref, [](auto const& e) { return e.second % 4 != 0; });
+    check();
+}
+
+TEST_CASE("hashed_layered_map matches layered_map") {
+    hashed_layered_map<int> hashed;
+    layered_map<int> tree;
+    for (GlobalPosition p : GlobalAabb{{0,0,0}, {70,40,10}}) {
+        hashed[p] = static_cast<int>(p.x);
+        tree[p] = static_cast<int>(p.x);
+    }
+    hashed.erase(GlobalPosition{5,5,5});
+    tree.erase(GlobalPosition{5,5,5});
+    CHECK(hashed.size() == tree.size());
+    CHECK(std::ranges::equal(hashed, tree));
+
+    hashed_layered_map<int> other;
+    for (GlobalPosition p : GlobalAabb{{60,30,0}, {100,50,10}}) other[p] = 1;
+    auto inter = std::ranges::to<std::vector<std::pair<GlobalPosition, int>>>(
+        hashed_layered_map<int>::overlap(hashed, other));
+    CHECK(inter.size() == 10u * 10u * 10u);
+}
+
+TEST_CASE("hashed_layered_map copy and move assignment") {
+    hashed_layered_map<int> a;
+    for (GlobalPosition p : GlobalAabb{{0,0,0}, {40,40,4}}) a[p] = static_cast<int>(p.y);
+    hashed_layered_map<int> b;
+    b[GlobalPosition{500, 500, 500}] = 7;
+    b = a;
+    CHECK(std::ranges::equal(b, a));
+    b.erase(GlobalPosition{1, 1, 1});
+    CHECK(b.size() + 1 == a.size());
+    CHECK(a.find(GlobalPosition{1, 1, 1}) != a.end());
+
+    hashed_layered_map<int> c;
+    c = std::move(b);
+    CHECK(c.size() + 1 == a.size());
+    b = c;
+    CHECK(std::ranges::equal(b, c));
+}
+
+TEST_CASE("hashed_layered_map neighbourhood writes survive rehash") {
+    hashed_layered_map<int> map;
+    map[GlobalPosition{40, 40, 40}] = 1;
+    auto near = map.neighbourhood(ChunkPosition{1, 1, 1});
+    for (std::uint32_t z = 0; z < 3; ++z)
+        for (std::uint32_t y = 0; y < 3; ++y)
+            for (std::uint32_t x = 0; x < 3; ++x)
+                near[GlobalPosition{x * 32 + 1, y * 32 + 1, z * 32 + 1}] = static_cast<int>(x + y + z);
+    CHECK(map.size() == 28u);
+    CHECK(near.at(GlobalPosition{40, 40, 40}) == 1);
+    CHECK(near.count_neighbours26(GlobalPosition{33, 33, 33}) == 0);
+    CHECK(map.at(GlobalPosition{65, 65, 65}) == 6);
+}
+
+TEST_CASE("hashed_layered_map neighbourhood re-pins after inserts through the map") {
+    hashed_layered_map<int> map;
+    map[GlobalPosition{33, 33, 33}] = 3;
+    map[GlobalPosition{64, 33, 33}] = 4;
+    auto near = map.neighbourhood(ChunkPosition{1, 1, 1});
+    CHECK(near.at(GlobalPosition{33, 33, 33}) == 3);
+    for (std::uint32_t i = 0; i < 200; ++i)
+        map[GlobalPosition{1000 + i * 32, 7, 7}] = static_cast<int>(i);
+    CHECK(near.at(GlobalPosition{33, 33, 33}) == 3);
+    CHECK(near.count_neighbours6(GlobalPosition{63, 33, 33}) == 1);
+    map.erase(GlobalPosition{64, 33, 33});
+    CHECK_FALSE(near.contains(GlobalPosition{64, 33, 33}));
+}
@@ -1,6 +1,7 @@
 #include "doctest.h"
 #include "chunk_map.h"
 #include "bucket_map.h"
+#include "chunk_hash_map.h"
 #include <vector>
 #include <algorithm>
 #include <string>
@@ -140,3 +141,97 @@ TEST_CASE("ranges to move chunk_map") {
     CHECK(src.empty());
 }
 
+
+TEST_CASE("chunk_map with plain ChunkPosition outer keys") {
+    using inner_t = std::map<LocalPosition, int>;
+    chunk_map<int, inner_t, std::map<ChunkPosition, inner_t>> cm;
+    cm[GlobalPosition{40,0,0}] = 2;
+    cm[GlobalPosition{1,0,0}] = 1;
+    std::vector<GlobalPosition> keys;
+    for (auto const& [gp, v] : cm) keys.push_back(gp);
+    CHECK(keys == std::vector<GlobalPosition>{GlobalPosition{1,0,0}, GlobalPosition{40,0,0}});
+}
+
+TEST_CASE("chunk_map hot chunk cache") {
+    chunk_map<int> cm;
+    for (std::uint32_t x = 0; x < 32; ++x) cm[GlobalPosition{x, 0, 0}] = static_cast<int>(x);
+    auto stats = cm.cache_stats();
+    CHECK(stats.misses == 1);
+    CHECK(stats.hits == 31);
+
+    cm.reset_cache_stats();
+    for (std::uint32_t x = 0; x < 32; ++x) CHECK(cm.at(GlobalPosition{x, 0, 0}) == static_cast<int>(x));
+    CHECK(cm.cache_stats().hits == 32);
+    CHECK(cm.cache_stats().hit_rate() == doctest::Approx(1.0));
+
+    cm[GlobalPosition{40, 0, 0}] = 40;
+    for (std::uint32_t x = 0; x < 32; ++x) CHECK(cm.erase(GlobalPosition{x, 0, 0}) == 1);
+    CHECK(cm.find(GlobalPosition{3, 0, 0}) == cm.end());
+    CHECK(cm.at(GlobalPosition{40, 0, 0}) == 40);
+    cm[GlobalPosition{3, 0, 0}] = 7;
+    CHECK(cm.size() == 2);
+
+    auto copy = cm;
+    cm.clear();
+    CHECK(cm.find(GlobalPosition{40, 0, 0}) == cm.end());
+    CHECK(copy.at(GlobalPosition{40, 0, 0}) == 40);
+    CHECK(copy.at(GlobalPosition{3, 0, 0}) == 7);
+
+    auto moved = std::move(copy);
+    CHECK(moved.at(GlobalPosition{3, 0, 0}) == 7);
+    CHECK(std::ranges::distance(moved) == 2);
+}
+
+TEST_CASE("chunk_map cache survives hash table growth") {
+    using inner_t = std::map<LocalPosition, int>;
+    chunk_map<int, inner_t, chunk_hash_map<ChunkKey, inner_t>> cm;
+    cm[GlobalPosition{0, 0, 0}] = -1;
+    for (std::uint32_t i = 0; i < 200; ++i) {
+        cm[GlobalPosition{i * 32, 0, 0}] = static_cast<int>(i);
+        CHECK(cm.at(GlobalPosition{0, 0, 0}) == 0);
+    }
+    for (std::uint32_t i = 0; i < 200; i += 2) cm.erase(GlobalPosition{i * 32, 0, 0});
+    for (std::uint32_t i = 1; i < 200; i += 2) CHECK(cm.at(GlobalPosition{i * 32, 0, 0}) == static_cast<int>(i));
+    CHECK(cm.size() == 100);
+}
+
+TEST_CASE("chunk_map neighbourhood accessor") {
+    chunk_map<int> cm;
+    for (std::uint32_t z = 30; z < 34; ++z)
+        for (std::uint32_t y = 30; y < 34; ++y)
+            for (std::uint32_t x = 30; x < 34; ++x)
+                cm[GlobalPosition{x, y, z}] = static_cast<int>(x + y + z);
+
+    auto near = cm.neighbourhood(ChunkPosition{0, 0, 0});
+    CHECK(near.covers(GlobalPosition{63, 63, 63}));
+    CHECK_FALSE(near.covers(GlobalPosition{64, 0, 0}));
+    CHECK(near.contains(GlobalPosition{32, 32, 32}));
+    CHECK_FALSE(near.contains(GlobalPosition{34, 31, 31}));
+    CHECK(near.at(GlobalPosition{33, 30, 31}) == 94);
+    CHECK_THROWS_AS(near.at(GlobalPosition{40, 40, 40}), std::out_of_range);
+
+    CHECK(near.count_neighbours6(GlobalPosition{31, 31, 31}) == 6);
+    CHECK(near.count_neighbours26(GlobalPosition{31, 31, 31}) == 26);
+    CHECK(near.count_neighbours6(GlobalPosition{30, 30, 30}) == 3);
+    CHECK(near.count_neighbours26(GlobalPosition{30, 30, 30}) == 7);
+    CHECK(near.has_all_neighbours6(GlobalPosition{32, 31, 32}));
+    CHECK_FALSE(near.has_all_neighbours6(GlobalPosition{33, 31, 32}));
+
+    int sum = 0;
+    near.for_each_neighbour6(GlobalPosition{31, 31, 31}, [&](GlobalPosition n, int v) {
+        CHECK(cm.at(n) == v);
+        sum += v;
+    });
+    CHECK(sum == 6 * 93);
+
+    auto edge = cm.neighbourhood(ChunkPosition{0, 0, 0});
+    CHECK(edge.count_neighbours26(GlobalPosition{0, 0, 0}) == 0);
+
+    auto writer = cm.neighbourhood(ChunkPosition{1, 1, 1});
+    writer[GlobalPosition{64, 64, 64}] = 5;
+    writer[GlobalPosition{32, 32, 32}] = 7;
+    CHECK(writer.at(GlobalPosition{64, 64, 64}) == 5);
+    CHECK(writer.contains(GlobalPosition{33, 33, 33}));
+    CHECK(cm.at(GlobalPosition{64, 64, 64}) == 5);
+    CHECK(cm.at(GlobalPosition{32, 32, 32}) == 7);
+}
@@ -0,0 +1,98 @@
+#include "doctest.h"
+#include "csg_expression.h"
+#include "layered_map.h"
+#include "layered_map_algo.h"
+#include "aabb.h"
+#include <vector>
+#include <utility>
+
+namespace checks {
+    using map_t  = layered_map<int>;
+    using leaf_t = csg::leaf<map_t>;
+
+    template<typename M>
+    concept lazy_from = requires(M&& m) { csg::lazy(std::forward<M>(m)); };
+    template<typename A, typename B>
+    concept lazy_union = requires(A&& a, B&& b) { std::forward<A>(a) | std::forward<B>(b); };
+    template<typename A, typename B>
+    concept lazy_difference = requires(A&& a, B&& b) { std::forward<A>(a) - std::forward<B>(b); };
+
+    static_assert(lazy_from<const map_t&>);
+    static_assert(!lazy_from<map_t>);
+    static_assert(lazy_union<leaf_t, const map_t&>);
+    static_assert(lazy_union<map_t&, const leaf_t&>);
+    static_assert(!lazy_union<leaf_t, map_t>);
+    static_assert(!lazy_union<map_t, leaf_t&>);
+    static_assert(lazy_difference<leaf_t, leaf_t>);
+    static_assert(!lazy_difference<const leaf_t&, const map_t&&>);
+}
+
+/// @brief Create an axis aligned box filled with a value.
+static layered_map<int> make_box(GlobalPosition min_corner,
+                                 GlobalPosition max_corner,
+                                 int value = 1)
+{
+    layered_map<int> map;
+    for (GlobalPosition p : GlobalAabb{min_corner, max_corner})
+        map[p] = value;
+    return map;
+}
+
+/// @brief Copy a map into a vector of pairs.
+template<typename Map>
+static std::vector<std::pair<GlobalPosition, int>> as_pairs(const Map& map)
+{
+    std::vector<std::pair<GlobalPosition, int>> out;
+    for (auto const& [gp, v] : map) out.emplace_back(gp, v);
+    return out;
+}
+
+TEST_CASE("csg expression matches eager operators") {
+    auto a = make_box({0,0,0}, {40,10,10}, 1);
+    auto b = make_box({30,0,0}, {70,10,10}, 2);
+    auto c = make_box({0,5,5}, {100,8,8}, 3);
+    auto d = make_box({20,0,0}, {90,6,6}, 4);
+
+    auto expr = (csg::lazy(a) | b) - (csg::lazy(c) & d);
+    auto eager = (a | b) - (c & d);
+    auto lazy = csg::evaluate(expr);
+    CHECK(as_pairs(lazy) == as_pairs(eager));
+    CHECK(lazy.size() == eager.size());
+
+    auto sym = csg::evaluate(csg::lazy(a) ^ b);
+    CHECK(as_pairs(sym) == as_pairs(layered_map<int>::combine<set_op::exclusive>(a, b)));
+
+    auto mixed = csg::evaluate(a & (csg::lazy(b) | c));
+    CHECK(as_pairs(mixed) == as_pairs(a & (b | c)));
+}
+
+TEST_CASE("csg expression streams voxels in Morton order") {
+    auto a = make_box({0,0,0}, {40,10,10}, 1);
+    auto b = make_box({30,0,0}, {70,10,10}, 2);
+
+    std::vector<std::pair<GlobalPosition, int>> streamed;
+    csg::evaluate(csg::lazy(a) - b, [&](GlobalPosition gp, int v) { streamed.emplace_back(gp, v); });
+    CHECK(streamed == as_pairs(a - b));
+}
+
+TEST_CASE("csg expression skips chunks that are provably empty") {
+    auto a = make_box({0,0,0}, {10,10,10});
+    auto far = make_box({500,0,0}, {510,10,10});
+    auto near = make_box({5,5,5}, {8,8,8});
+
+    CHECK(csg::support(csg::lazy(a) & far).empty());
+    CHECK(csg::evaluate(csg::lazy(a) & far).empty());
+    CHECK(csg::support(csg::lazy(a) - far).size() == 1);
+    CHECK(csg::support((csg::lazy(a) | far) & near).size() == 1);
+    CHECK(csg::support(csg::lazy(a) | far).size() == 2);
+    CHECK(csg::evaluate(csg::lazy(near) - a).empty());
+}
+
+TEST_CASE("csg expression over std::map chunks") {
+    chunk_map<int> a;
+    chunk_map<int> b;
+    for (GlobalPosition p : GlobalAabb{{0,0,0}, {40,4,4}}) a[p] = 1;
+    for (GlobalPosition p : GlobalAabb{{20,2,2}, {60,6,6}}) b[p] = 2;
+    auto out = csg::evaluate((csg::lazy(a) | b) - (csg::lazy(a) & b));
+    CHECK(as_pairs(out) == as_pairs(chunk_map<int>::combine<set_op::exclusive>(a, b)));
+}
@@ -1,6 +1,7 @@
 #include "doctest.h"
 #include "flat_vector.h"
 #include "flat_vector_array_packed.h"
+#include "test_random.h"
 #include <vector>
 #include <array>
 #include <ranges>
@@ -55,3 +56,109 @@ TEST_CASE("compare with std::vector") {
         CHECK(fv[0][i] == sv[0][i]);
     }
 }
+
+TEST_CASE("push_back plain values, unpack and occupancy") {
+    std::array<int, 64> vals{};
+    vals[0] = 3;
+    vals[17] = 1;
+    vals[63] = 1000;
+
+    flat_vector<array_packed<64, int>> fv;
+    fv.resize(1);
+    fv[0][5] = 7;
+    fv.push_back(vals);
+    fv.push_back(std::array<int, 64>{});
+
+    REQUIRE(fv.size() == 3);
+    CHECK(fv[1][0] == 3);
+    CHECK(fv[1][17] == 1);
+    CHECK(fv[1][63] == 1000);
+    CHECK(fv.unpack(1) == vals);
+    CHECK(fv.unpack(0)[5] == 7);
+    CHECK(fv.occupancy(1).to_ullong() == (1ull | 1ull << 17 | 1ull << 63));
+    CHECK(fv.occupancy(2).none());
+    fv[2][4] = 2;
+    CHECK(fv.occupancy(2).test(4));
+    CHECK(fv[1][63] == 1000);
+}
+
+TEST_CASE("element queries by value") {
+    std::array<int, 64> vals{};
+    vals[1] = 3;
+    vals[9] = 3;
+    vals[40] = 12;
+    flat_vector<array_packed<64, int>> fv;
+    fv.push_back(std::array<int, 64>{});
+    fv.push_back(vals);
+
+    CHECK(fv.find_equal(1, 3).to_ullong() == (1ull << 1 | 1ull << 9));
+    CHECK(fv.count_equal(1, 0) == 61u);
+    CHECK(fv.count_equal(1, 12) == 1u);
+    CHECK(fv.find_equal(1, 100).none());
+    CHECK(fv.less_than(1, 12).count() == 63u);
+    CHECK(fv.less_than(1, 13).all());
+    CHECK(fv.count_equal(0, 0) == 64u);
+    CHECK(fv.less_than(0, 0).none());
+}
+
+TEST_CASE("store drops planes the new values do not need") {
+    std::array<int, 64> wide{};
+    wide[7] = 1 << 20;
+    std::array<int, 64> narrow{};
+    narrow[2] = 3;
+    flat_vector<array_packed<64, int>> fv;
+    fv.push_back(wide);
+    fv.push_back(wide);
+    fv.push_back(wide);
+    fv.store(1, narrow);
+    CHECK(fv.planes(1) == 2u);
+    CHECK(fv.unpack(0) == wide);
+    CHECK(fv.unpack(1) == narrow);
+    CHECK(fv.unpack(2) == wide);
+    fv.store(1, std::array<int, 64>{});
+    CHECK(fv.planes(1) == 0u);
+    CHECK(fv.unpack(2) == wide);
+}
+
+TEST_CASE("elements copy out as the chosen plane storage") {
+    flat_vector<array_packed<64, int, plain_encoding, fixed_planes<8>>> fv;
+    std::array<int, 64> vals{};
+    vals[5] = 200;
+    fv.push_back(vals);
+    array_packed<64, int, plain_encoding, fixed_planes<8>> copy = fv[0];
+    CHECK(copy[5] == 200);
+    CHECK(copy.planes() == 8u);
+    fv.push_back(copy);
+    CHECK(fv.unpack(1) == vals);
+}
+
+TEST_CASE("plane offsets stay right across blocks as elements grow and shrink") {
+    flat_vector<array_packed<64, int>> fv;
+    std::vector<std::array<int, 64>> ref(300);
+    fv.resize(ref.size());
+    test_rng rng(3);
+    for (int step = 0; step < 3000; ++step) {
+        const std::size_t elem = rng.below(static_cast<std::uint32_t>(ref.size()));
+        const std::size_t lane = rng.below(64);
+        const int value = step % 5 == 0 ? 0 : static_cast<int>(rng.below(1u << (step % 20)));
+        if (step % 7 == 0) {
+            ref[elem].fill(0);
+            ref[elem][lane] = value;
+            fv.store(elem, ref[elem]);
+        } else {
+            ref[elem][lane] = value;
+            fv[elem][lane] = value;
+        }
+    }
+    for (std::size_t e = 0; e < ref.size(); ++e) CHECK(fv.unpack(e) == ref[e]);
+
+    fv.resize(130);
+    fv.push_back(ref[5]);
+    fv.resize(200);
+    CHECK(fv.unpack(129) == ref[129]);
+    CHECK(fv.unpack(130) == ref[5]);
+    CHECK(fv.planes(199) == 0u);
+    fv[199][3] = 9;
+    CHECK(fv.unpack(130) == ref[5]);
+    CHECK(fv[199][3] == 9);
+}
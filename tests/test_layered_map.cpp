@@ -20,6 +20,8 @@ namespace checks {
     static_assert(std::ranges::common_range<map_t>);
     static_assert(std::same_as<std::ranges::range_value_t<map_t>,
                                std::pair<GlobalPosition, std::string>>);
+    static_assert(std::ranges::input_range<decltype(views::merge_n(std::declval<std::vector<map_t>&>(), key_less{}))>);
+    static_assert(std::ranges::input_range<decltype(views::overlap_n(std::declval<std::vector<map_t>&>(), key_less{}))>);
 }
 
 /// @brief Create axis aligned box filled with a value.
@@ -33,6 +35,15 @@ static layered_map<int> make_box(GlobalPosition min_corner,
     return map;
 }
 
+/// @brief Copy a map or view of int voxels into a vector of pairs.
+template<typename Range>
+static std::vector<std::pair<GlobalPosition, int>> as_pairs(Range&& range)
+{
+    std::vector<std::pair<GlobalPosition, int>> out;
+    for (auto const& [gp, v] : range) out.emplace_back(gp, v);
+    return out;
+}
+
 TEST_CASE("layered_map basic insertion") {
     layered_map<int> lm;
     lm[GlobalPosition{1,2,3}] = 10;
@@ -118,3 +129,244 @@ TEST_CASE("layered_map csg operations") {
         CHECK(rhs.find(gp) == rhs.end());
 }
 
+TEST_CASE("chunk-level csg copies, drops and combines chunks") {
+    auto lhs = make_box(GlobalPosition{0,0,0}, GlobalPosition{40,8,8});
+    auto rhs = make_box(GlobalPosition{30,4,4}, GlobalPosition{100,10,10});
+    rhs[GlobalPosition{0,0,0}] = 9;
+
+    using lm = layered_map<int>;
+    CHECK(as_pairs(lm::combine<set_op::merge>(lhs, rhs)) == as_pairs(lm::merge(lhs, rhs)));
+    CHECK(as_pairs(lm::combine<set_op::overlap>(lhs, rhs)) == as_pairs(lm::overlap(lhs, rhs)));
+    CHECK(as_pairs(lm::combine<set_op::subtract>(lhs, rhs)) == as_pairs(lm::subtract(lhs, rhs)));
+    CHECK(as_pairs(lm::combine<set_op::exclusive>(lhs, rhs)) == as_pairs(lm::exclusive(lhs, rhs)));
+    CHECK((lhs & rhs).at(GlobalPosition{0,0,0}) == 1);
+    CHECK((lhs - lhs).empty());
+
+    chunk_map<int> tree_lhs;
+    chunk_map<int> tree_rhs;
+    tree_lhs.insert_range(lhs);
+    tree_rhs.insert_range(rhs);
+    auto tree_sym = chunk_map<int>::combine<set_op::exclusive>(tree_lhs, tree_rhs);
+    CHECK(as_pairs(tree_sym) == as_pairs(lm::exclusive(lhs, rhs)));
+}
+TEST_CASE("in-place csg only touches rhs chunks") {
+    auto world = make_box(GlobalPosition{0,0,0}, GlobalPosition{96,8,8});
+    auto brush = make_box(GlobalPosition{30,2,2}, GlobalPosition{36,6,6}, 7);
+    brush[GlobalPosition{200,0,0}] = 7;
+
+    auto painted = world;
+    painted |= brush;
+    CHECK(as_pairs(painted) == as_pairs(world | brush));
+    CHECK(painted.at(GlobalPosition{200,0,0}) == 7);
+
+    auto carved = world;
+    carved -= brush;
+    CHECK(as_pairs(carved) == as_pairs(world - brush));
+    carved -= world;
+    CHECK(carved.empty());
+
+    auto kept = world;
+    kept &= brush;
+    CHECK(as_pairs(kept) == as_pairs(world & brush));
+    CHECK(kept.size() == 6u * 4u * 4u);
+
+    auto self = world;
+    self |= self;
+    self &= self;
+    CHECK(self.size() == world.size());
+    self -= self;
+    CHECK(self.empty());
+
+    hashed_layered_map<int> hashed;
+    hashed_layered_map<int> hashed_brush;
+    hashed.insert_range(world);
+    hashed_brush.insert_range(brush);
+    hashed.combine_with<set_op::exclusive>(hashed_brush);
+    CHECK(as_pairs(hashed) == as_pairs(layered_map<int>::exclusive(world, brush)));
+
+    chunk_map<int> tree;
+    chunk_map<int> tree_brush;
+    tree.insert_range(world);
+    tree_brush.insert_range(brush);
+    tree.combine_with<set_op::subtract>(tree_brush);
+    CHECK(as_pairs(tree) == as_pairs(world - brush));
+}
+
+TEST_CASE("seeking views match linear views") {
+    auto world = make_box(GlobalPosition{0,0,0}, GlobalPosition{96,24,24});
+    layered_map<int> brush;
+    for (std::uint32_t x : {5u, 40u, 41u, 95u, 300u, 301u})
+        brush[GlobalPosition{x, 7, 9}] = 2;
+    auto linear = [](auto const& a, auto const& b) { return a.first < b.first; };
+
+    CHECK(as_pairs(views::overlap(world, brush, key_less{})) == as_pairs(views::overlap(world, brush, linear)));
+    CHECK(as_pairs(views::overlap(brush, world, key_less{})) == as_pairs(views::overlap(brush, world, linear)));
+    CHECK(as_pairs(views::subtract(brush, world, key_less{})) == as_pairs(views::subtract(brush, world, linear)));
+    CHECK(as_pairs(layered_map<int>::overlap(brush, world)).size() == 4u);
+    CHECK(as_pairs(layered_map<int>::subtract(brush, world)).size() == 2u);
+
+    auto it = world.lower_bound(GlobalPosition{40, 7, 9});
+    REQUIRE(it != world.end());
+    CHECK(it->first == GlobalPosition{40, 7, 9});
+    CHECK(world.lower_bound(GlobalPosition{300, 0, 0}) == world.end());
+    auto first = world.begin();
+    CHECK(first.seek(GlobalPosition{0, 0, 0}) == world.begin());
+
+    chunk_map<int> tree;
+    tree.insert_range(world);
+    auto tree_it = tree.cbegin();
+    for (auto const& [gp, v] : world) {
+        tree_it.seek(gp);
+        REQUIRE(tree_it != tree.cend());
+        CHECK(tree_it->first == gp);
+    }
+}
+
+TEST_CASE("seeking hashed and paged maps match linear views") {
+    auto world = make_box(GlobalPosition{0,0,0}, GlobalPosition{96,24,24});
+    hashed_layered_map<int> hashed;
+    paged_layered_map<int> paged;
+    hashed.insert_range(world);
+    paged.insert_range(world);
+    hashed_layered_map<int> hashed_brush;
+    paged_layered_map<int> paged_brush;
+    for (std::uint32_t x : {5u, 40u, 41u, 95u, 300u, 301u}) {
+        hashed_brush[GlobalPosition{x, 7, 9}] = 2;
+        paged_brush[GlobalPosition{x, 7, 9}] = 2;
+    }
+    auto linear = [](auto const& a, auto const& b) { return a.first < b.first; };
+
+    CHECK(as_pairs(views::overlap(hashed, hashed_brush, key_less{})) == as_pairs(views::overlap(hashed, hashed_brush, linear)));
+    CHECK(as_pairs(views::subtract(hashed_brush, hashed, key_less{})) == as_pairs(views::subtract(hashed_brush, hashed, linear)));
+    CHECK(as_pairs(views::overlap(paged, paged_brush, key_less{})) == as_pairs(views::overlap(paged, paged_brush, linear)));
+    CHECK(as_pairs(views::subtract(paged_brush, paged, key_less{})) == as_pairs(views::subtract(paged_brush, paged, linear)));
+
+    auto hashed_it = hashed.cbegin();
+    auto paged_it = paged.cbegin();
+    for (std::uint32_t x : {3u, 40u, 70u, 95u}) {
+        GlobalPosition gp{x, 20, 1};
+        hashed_it.seek(gp);
+        paged_it.seek(gp);
+        REQUIRE(hashed_it != hashed.cend());
+        REQUIRE(paged_it != paged.cend());
+        CHECK(hashed_it->first == gp);
+        CHECK(paged_it->first == gp);
+    }
+    CHECK(hashed_it.seek(GlobalPosition{500, 0, 0}) == hashed.cend());
+    CHECK(paged_it.seek(GlobalPosition{500, 0, 0}) == paged.cend());
+}
+
+TEST_CASE("n-ary merge and overlap match chained views") {
+    std::vector<layered_map<int>> maps;
+    for (std::uint32_t i = 0; i < 7; ++i)
+        maps.push_back(make_box(GlobalPosition{4 * i, 0, 0}, GlobalPosition{4 * i + 40, 6, 6}, i));
+    maps.push_back(layered_map<int>{});
+
+    auto all = maps[0];
+    auto common = maps[0];
+    for (std::size_t i = 1; i + 1 < maps.size(); ++i) {
+        all = all | maps[i];
+        common = common & maps[i];
+    }
+    CHECK(as_pairs(views::merge_n(maps, key_less{})) == as_pairs(all));
+    CHECK(as_pairs(views::overlap_n(maps, key_less{})).empty());
+    maps.pop_back();
+    CHECK(as_pairs(views::overlap_n(maps, key_less{})) == as_pairs(common));
+    CHECK(!common.empty());
+
+    std::vector<std::ranges::ref_view<const layered_map<int>>> refs(maps.begin(), maps.begin() + 1);
+    CHECK(as_pairs(views::merge_n(refs, key_less{})) == as_pairs(maps[0]));
+    CHECK(as_pairs(views::overlap_n(refs, key_less{})) == as_pairs(maps[0]));
+    refs.clear();
+    CHECK(as_pairs(views::merge_n(refs, key_less{})).empty());
+    CHECK(as_pairs(views::overlap_n(refs, key_less{})).empty());
+}
+
+TEST_CASE("layered_map compact releases overwritten values") {
+    auto world = make_box(GlobalPosition{0,0,0}, GlobalPosition{80,8,8});
+    for (int pass = 0; pass < 20; ++pass)
+        for (GlobalPosition p : GlobalAabb{GlobalPosition{0,0,0}, GlobalPosition{80,8,8}})
+            world[p] = pass + static_cast<int>(p.x);
+    for (GlobalPosition p : GlobalAabb{GlobalPosition{64,0,0}, GlobalPosition{80,8,8}})
+        world.erase(p);
+    std::vector<std::pair<GlobalPosition, int>> before(world.begin(), world.end());
+
+    std::size_t chunks = 0;
+    world.compact();
+    world.for_each_chunk([&](ChunkPosition, auto const& inner) {
+        ++chunks;
+        CHECK(inner.stored_values() == 32u);
+    });
+    CHECK(chunks == 2u);
+    std::vector<std::pair<GlobalPosition, int>> after(world.begin(), world.end());
+    CHECK(after == before);
+}
+
+TEST_CASE("layered_map insert_range groups by chunk") {
+    layered_map<int> lm;
+    lm[GlobalPosition{1,1,1}] = 5;
+    std::vector<std::pair<GlobalPosition, int>> vals{
+        {GlobalPosition{40,0,0}, 1}, {GlobalPosition{1,1,1}, 2},
+        {GlobalPosition{0,0,0}, 3},  {GlobalPosition{40,0,0}, 4},
+        {GlobalPosition{70000,3,9}, 6}
+    };
+    lm.insert_range(vals);
+    CHECK(lm.size() == 4);
+    CHECK(lm.at(GlobalPosition{1,1,1}) == 5);
+    CHECK(lm.at(GlobalPosition{40,0,0}) == 1);
+    CHECK(lm.at(GlobalPosition{0,0,0}) == 3);
+    CHECK(lm.at(GlobalPosition{70000,3,9}) == 6);
+}
+
+TEST_CASE_TEMPLATE("layered_map with configurable chunk edge", Edge,
+                   std::integral_constant<std::uint32_t, 8>,
+                   std::integral_constant<std::uint32_t, 16>,
+                   std::integral_constant<std::uint32_t, 64>) {
+    using map_t = layered_map<int, Edge::value>;
+    static_assert(map_t::chunk_edge == Edge::value);
+
+    map_t lhs;
+    map_t rhs;
+    layered_map<int> lhs_ref;
+    layered_map<int> rhs_ref;
+    for (GlobalPosition p : GlobalAabb{{0,0,0}, {20,20,20}}) { lhs[p] = 1; lhs_ref[p] = 1; }
+    for (GlobalPosition p : GlobalAabb{{10,10,10}, {30,30,30}}) { rhs[p] = 2; rhs_ref[p] = 2; }
+
+    CHECK(std::ranges::is_sorted(lhs, {}, [](auto const& e) { return e.first; }));
+    CHECK(std::ranges::equal(lhs, lhs_ref));
+    CHECK(std::ranges::equal(lhs | rhs, lhs_ref | rhs_ref));
+    CHECK(std::ranges::equal(lhs & rhs, lhs_ref & rhs_ref));
+    CHECK(std::ranges::equal(lhs - rhs, lhs_ref - rhs_ref));
+    CHECK(std::ranges::equal(inset(lhs), inset(lhs_ref)));
+    CHECK(std::ranges::equal(extrude(rhs), extrude(rhs_ref)));
+
+    map_t bulk;
+    bulk.insert_range(rhs_ref);
+    CHECK(std::ranges::equal(bulk, rhs_ref));
+}
+
+TEST_CASE("layered_map assign_sorted keeps last duplicate") {
+    layered_map<int> lm;
+    lm[GlobalPosition{1,1,1}] = 5;
+    std::vector<std::pair<GlobalPosition, int>> vals{
+        {GlobalPosition{40,0,0}, 1}, {GlobalPosition{1,1,1}, 2},
+        {GlobalPosition{0,0,0}, 3},  {GlobalPosition{40,0,0}, 4},
+        {GlobalPosition{70000,3,9}, 6}
+    };
+    lm.assign_sorted(vals);
+    CHECK(lm.size() == 4);
+    CHECK(lm.at(GlobalPosition{1,1,1}) == 2);
+    CHECK(lm.at(GlobalPosition{40,0,0}) == 4);
+    CHECK(lm.at(GlobalPosition{0,0,0}) == 3);
+
+    chunk_map<int> tree;
+    tree.assign_sorted(vals);
+    CHECK(std::ranges::equal(tree, lm, [](auto const& a, auto const& b) {
+        return a.first == b.first && a.second == b.second;
+    }));
+
+    std::vector<std::pair<GlobalPosition, int>> reversed(lm.begin(), lm.end());
+    std::ranges::reverse(reversed);
+    auto back = std::ranges::to<layered_map<int>>(reversed);
+    CHECK(std::ranges::equal(back, lm));
+}
@@ -85,7 +85,7 @@ TEST_CASE("layered_map algorithm chaining") {
 
     auto result = overlap(subtract(merge(boxA, boxB), boxC), sphereD);
 
-    constexpr std::size_t expected_count = 482;
+    constexpr std::size_t expected_count = 451;
     constexpr GlobalPosition expected_min{1,1,1};
     constexpr GlobalPosition expected_max{11,11,11};
 
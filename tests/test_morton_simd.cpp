@@ -0,0 +1,36 @@
+#include "doctest.h"
+#include "morton_simd.h"
+#include "test_random.h"
+#include <vector>
+
+TEST_CASE("batch encode matches scalar encode") {
+    auto pts = random_positions(37, 1u << 21, 7);
+    std::vector<std::uint64_t> codes(pts.size());
+    morton_encode_batch(pts, codes);
+    for (std::size_t i = 0; i < pts.size(); ++i)
+        CHECK(codes[i] == pts[i].encode());
+
+    std::vector<std::uint32_t> xs, ys, zs;
+    for (auto p : pts) { xs.push_back(p.x); ys.push_back(p.y); zs.push_back(p.z); }
+    std::vector<std::uint64_t> soa(pts.size());
+    morton_encode_batch(xs, ys, zs, soa);
+    CHECK(soa == codes);
+}
+
+TEST_CASE("batch decode round trips") {
+    auto pts = random_positions(29, 1u << 21, 7);
+    std::vector<std::uint64_t> codes(pts.size());
+    morton_encode_batch(pts, codes);
+
+    std::vector<GlobalPosition> back(pts.size());
+    morton_decode_batch(codes, back);
+    CHECK(back == pts);
+
+    std::vector<std::uint32_t> xs(pts.size()), ys(pts.size()), zs(pts.size());
+    morton_decode_batch(codes, xs, ys, zs);
+    for (std::size_t i = 0; i < pts.size(); ++i) {
+        CHECK(xs[i] == pts[i].x);
+        CHECK(ys[i] == pts[i].y);
+        CHECK(zs[i] == pts[i].z);
+    }
+}
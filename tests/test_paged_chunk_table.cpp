@@ -0,0 +1,148 @@
+#include "doctest.h"
+#include "paged_chunk_table.h"
+#include "layered_map.h"
+#include "aabb.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <ranges>
+#include <stdexcept>
+
+namespace checks {
+    using table_t = paged_chunk_table<ChunkKey, std::string, 6>;
+    using iter_t  = table_t::iterator;
+    using citer_t = table_t::const_iterator;
+
+    static_assert(std::forward_iterator<iter_t>);
+    static_assert(std::forward_iterator<citer_t>);
+    static_assert(std::ranges::forward_range<table_t>);
+    static_assert(std::ranges::common_range<table_t>);
+    static_assert(std::same_as<std::ranges::range_value_t<table_t>,
+                               std::pair<const ChunkKey, std::string>>);
+    static_assert(table_t::code_limit == (std::uint64_t{1} << 18));
+    static_assert(std::forward_iterator<paged_layered_map<int>::const_iterator>);
+}
+
+TEST_CASE("paged_chunk_table insert find erase") {
+    paged_chunk_table<ChunkKey, int, 6> table;
+    std::map<ChunkKey, int> ref;
+    for (std::uint32_t i = 0; i < 500; ++i) {
+        ChunkPosition c{i % 13, i % 7, i / 9};
+        table[c] = static_cast<int>(i);
+        ref[c] = static_cast<int>(i);
+    }
+    CHECK(table.size() == ref.size());
+    for (std::uint32_t i = 0; i < 500; i += 3)
+        CHECK(table.erase(ChunkPosition{i % 13, i % 7, i / 9}) == ref.erase(ChunkPosition{i % 13, i % 7, i / 9}));
+    CHECK(table.size() == ref.size());
+    for (auto const& [k, v] : ref) {
+        REQUIRE(table.find(k) != table.end());
+        CHECK(table.find(k)->second == v);
+    }
+    CHECK(std::ranges::equal(table, ref));
+
+    CHECK(table.find(ChunkPosition{64, 0, 0}) == table.end());
+    CHECK_THROWS_AS(table.at(ChunkPosition{63, 63, 63}), std::out_of_range);
+    CHECK_THROWS_AS(table.try_emplace(ChunkPosition{0, 64, 0}), std::out_of_range);
+}
+
+TEST_CASE("paged_chunk_table iterates in morton order across pages") {
+    paged_chunk_table<ChunkKey, int, 6, 6> table;
+    std::map<ChunkKey, int> ref;
+    for (std::uint32_t i = 0; i < 300; ++i) {
+        ChunkPosition c{(i * 7919u) % 64, (i * 104729u) % 64, (i * 31u) % 64};
+        table.try_emplace(c, static_cast<int>(i));
+        ref.try_emplace(c, static_cast<int>(i));
+    }
+    CHECK(std::ranges::equal(table, ref));
+
+    auto it = table.erase(table.begin());
+    ref.erase(ref.begin());
+    CHECK(it == table.begin());
+    CHECK(std::ranges::equal(table, ref));
+
+    auto copy = table;
+    auto moved = std::move(table);
+    CHECK(std::ranges::equal(copy, ref));
+    CHECK(std::ranges::equal(moved, ref));
+    CHECK(table.empty());
+    table[ChunkPosition{1, 2, 3}] = 4;
+    CHECK(table.size() == 1u);
+
+    while (!moved.empty()) moved.erase(moved.begin());
+    CHECK(moved.begin() == moved.end());
+}
+
+TEST_CASE("paged_chunk_table lower_bound matches std::map") {
+    paged_chunk_table<ChunkKey, int, 6, 6> table;
+    std::map<ChunkKey, int> ref;
+    CHECK(table.lower_bound(ChunkPosition{0, 0, 0}) == table.end());
+    for (std::uint32_t i = 0; i < 300; ++i) {
+        ChunkPosition c{(i * 7919u) % 64, (i * 104729u) % 64, (i * 31u) % 64};
+        table.try_emplace(c, static_cast<int>(i));
+        ref.try_emplace(c, static_cast<int>(i));
+    }
+    for (std::uint32_t x = 0; x < 64; x += 3)
+        for (std::uint32_t y = 0; y < 64; y += 7) {
+            ChunkKey key{ChunkPosition{x, y, (x * y) % 64}};
+            auto it = table.lower_bound(key);
+            auto expected = ref.lower_bound(key);
+            REQUIRE((it == table.end()) == (expected == ref.end()));
+            if (it != table.end()) CHECK(it->first == expected->first);
+        }
+    CHECK(table.lower_bound(ChunkPosition{64, 0, 0}) == table.end());
+}
+
+TEST_CASE("paged_chunk_table allocates its directory on first insert") {
+    paged_chunk_table<ChunkKey, int> table;
+    CHECK(table.begin() == table.end());
+    CHECK_FALSE(table.contains(ChunkPosition{1, 2, 3}));
+    CHECK(table.erase(ChunkPosition{1, 2, 3}) == 0u);
+    auto empty_copy = table;
+    CHECK(empty_copy.empty());
+
+    table[ChunkPosition{255, 255, 255}] = 1;
+    table[ChunkPosition{1, 2, 3}] = 2;
+    auto copy = table;
+    CHECK(copy.size() == 2u);
+    CHECK(copy.begin()->second == 2);
+    CHECK(copy.at(ChunkPosition{255, 255, 255}) == 1);
+}
+
+TEST_CASE("paged_chunk_table leaves no trace of a throwing insert") {
+    struct throwing_value {
+        explicit throwing_value(bool fail) { if (fail) throw std::runtime_error("throwing_value"); }
+    };
+    paged_chunk_table<ChunkKey, throwing_value, 6> table;
+    CHECK_THROWS_AS(table.try_emplace(ChunkPosition{1, 2, 3}, true), std::runtime_error);
+    CHECK(table.empty());
+    CHECK_FALSE(table.contains(ChunkPosition{1, 2, 3}));
+    CHECK(table.begin() == table.end());
+
+    CHECK(table.try_emplace(ChunkPosition{1, 2, 3}, false).second);
+    CHECK_THROWS_AS(table.try_emplace(ChunkPosition{1, 2, 4}, true), std::runtime_error);
+    CHECK(table.size() == 1u);
+    CHECK(std::ranges::distance(table) == 1);
+    CHECK(table.erase(ChunkPosition{1, 2, 3}) == 1u);
+    CHECK(table.begin() == table.end());
+}
+
+TEST_CASE("paged_layered_map matches layered_map") {
+    paged_layered_map<int> paged;
+    layered_map<int> tree;
+    for (GlobalPosition p : GlobalAabb{{0,0,0}, {70,40,10}}) {
+        paged[p] = static_cast<int>(p.x);
+        tree[p] = static_cast<int>(p.x);
+    }
+    paged.erase(GlobalPosition{5,5,5});
+    tree.erase(GlobalPosition{5,5,5});
+    CHECK(paged.size() == tree.size());
+    CHECK(std::ranges::equal(paged, tree));
+
+    paged_layered_map<int> other;
+    for (GlobalPosition p : GlobalAabb{{60,30,0}, {100,50,10}}) other[p] = 1;
+    auto inter = std::ranges::to<std::vector<std::pair<GlobalPosition, int>>>(
+        paged_layered_map<int>::overlap(paged, other));
+    CHECK(inter.size() == 10u * 10u * 10u);
+    CHECK(paged.find(GlobalPosition{8192, 0, 0}) == paged.end());
+}
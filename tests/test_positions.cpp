@@ -0,0 +1,124 @@
+#include "doctest.h"
+#include "positions.h"
+#include "test_random.h"
+#include <vector>
+#include <algorithm>
+
+namespace checks {
+    static_assert(morton_encode64(1, 0, 0) == 1);
+    static_assert(morton_encode64(0, 1, 0) == 2);
+    static_assert(morton_encode64(0, 0, 1) == 4);
+    static_assert(morton_encode64(0x1fffff, 0x1fffff, 0x1fffff) == (std::uint64_t{1} << 63) - 1);
+    static_assert(morton_decode64(morton_encode64(100000, 7, 1500000))
+                  == std::array<std::uint32_t, 3>{100000, 7, 1500000});
+    static_assert(morton_encode64(5, 6, 7) == morton_encode(5, 6, 7));
+}
+
+TEST_CASE("64-bit morton round trip") {
+    for (std::uint32_t v : {0u, 1u, 1023u, 1024u, 65535u, 100000u, 2097151u}) {
+        auto p = morton_decode64(morton_encode64(v, v / 2, v / 3));
+        CHECK(p[0] == v);
+        CHECK(p[1] == v / 2);
+        CHECK(p[2] == v / 3);
+    }
+}
+
+TEST_CASE("global positions beyond 1024 do not alias") {
+    GlobalPosition a{5, 0, 0};
+    GlobalPosition b{5 + 1024, 0, 0};
+    CHECK(a.encode() != b.encode());
+    CHECK(a < b);
+    CHECK(GlobalPosition{b.encode()} == b);
+
+    GlobalPosition far{99999, 54321, 100000};
+    CHECK(GlobalPosition{far.encode()} == far);
+}
+
+TEST_CASE("global positions use all 21 bits per axis") {
+    constexpr std::uint32_t top = (1u << 21) - 1;
+    GlobalPosition edge{top, top, top};
+    CHECK(GlobalPosition{edge.encode()} == edge);
+    CHECK(edge.encode() == (std::uint64_t{1} << 63) - 1);
+    CHECK(GlobalPosition{0, 0, 0} < GlobalPosition{top, 0, 0});
+    CHECK(ChunkPosition{top, 0, 0}.encode() != ChunkPosition{0, 0, 0}.encode());
+}
+
+TEST_CASE("global code splits into chunk and local codes") {
+    GlobalPosition g{70001, 33, 99999};
+    ChunkPosition c{g};
+    LocalPosition l{g};
+    CHECK(g.encode() == ((c.encode() << 15) | morton_encode(l.x, l.y, l.z)));
+}
+
+TEST_CASE("position ordering matches morton order") {
+    std::vector<GlobalPosition> pts{
+        {100000, 0, 0}, {0, 100000, 0}, {0, 0, 100000},
+        {2048, 2048, 2048}, {1, 2, 3}, {1023, 1023, 1023}
+    };
+    std::ranges::sort(pts);
+    CHECK(std::ranges::is_sorted(pts, {}, [](GlobalPosition p) { return p.encode(); }));
+    CHECK(std::ranges::adjacent_find(pts) == pts.end());
+
+    std::vector<ChunkPosition> chunks;
+    for (auto p : pts) chunks.push_back(ChunkPosition{p});
+    std::ranges::sort(chunks);
+    CHECK(std::ranges::is_sorted(chunks, {}, [](ChunkPosition c) { return c.encode(); }));
+}
+
+TEST_CASE("local position equality agrees with ordering") {
+    std::vector<LocalPosition> pts;
+    for (std::uint32_t v : {0u, 1u, 31u, 32u, 63u})
+        pts.push_back({v, 63u - v, v / 2});
+    for (auto a : pts)
+        for (auto b : pts)
+            CHECK((a == b) == ((a <=> b) == 0));
+}
+
+TEST_CASE("morton kernels agree") {
+    for (std::uint32_t x = 0; x < 32; ++x)
+        for (std::uint32_t y = 0; y < 32; ++y)
+            for (std::uint32_t z = 0; z < 32; ++z) {
+                auto code = morton::encode_local(x, y, z);
+                CHECK(code == morton_encode(x, y, z));
+                CHECK(morton::decode_local(code) == std::array<std::uint32_t, 3>{x, y, z});
+            }
+
+    for (GlobalPosition p : random_positions(1000, 1u << 21, 12345)) {
+        const std::uint32_t x = p.x, y = p.y, z = p.z;
+        auto code = morton::encode64_magic(x, y, z);
+        CHECK(morton_encode64(x, y, z) == code);
+        CHECK(morton_decode64(code) == std::array<std::uint32_t, 3>{x, y, z});
+        CHECK(morton::encode32_magic(x & 1023, y & 1023, z & 1023)
+              == static_cast<std::uint32_t>(morton::encode64_magic(x & 1023, y & 1023, z & 1023)));
+    }
+}
+
+TEST_CASE("chunk key caches morton code") {
+    ChunkKey a{ChunkPosition{3, 1, 4}};
+    ChunkKey b{ChunkPosition{1, 5, 9}};
+    CHECK(a.code == ChunkPosition{3, 1, 4}.encode());
+    CHECK((a < b) == (ChunkPosition{3, 1, 4} < ChunkPosition{1, 5, 9}));
+    CHECK(static_cast<ChunkPosition>(a) == ChunkPosition{3, 1, 4});
+    CHECK(a == ChunkKey{ChunkPosition{3, 1, 4}});
+}
+
+TEST_CASE("chunk geometry splits and combines for every edge") {
+    auto check = []<std::uint32_t Edge>(std::integral_constant<std::uint32_t, Edge>) {
+        using geo = chunk_geometry<Edge>;
+        for (GlobalPosition g : {GlobalPosition{0, 0, 0}, GlobalPosition{63, 64, 65},
+                                 GlobalPosition{70001, 33, 99999}}) {
+            auto c = geo::chunk_of(g);
+            auto l = geo::local_of(g);
+            CHECK(l.x < Edge);
+            CHECK(geo::combine(c, l) == g);
+            CHECK(g.encode() == ((c.encode() << geo::code_bits) | l.encode()));
+            CHECK(LocalPosition{l.encode()} == l);
+        }
+    };
+    check(std::integral_constant<std::uint32_t, 8>{});
+    check(std::integral_constant<std::uint32_t, 16>{});
+    check(std::integral_constant<std::uint32_t, 32>{});
+    check(std::integral_constant<std::uint32_t, 64>{});
+    static_assert(chunk_geometry<64>::volume == 64u * 64u * 64u);
+    static_assert(ChunkPosition{GlobalPosition{70, 0, 0}} == default_chunk_geometry::chunk_of({70, 0, 0}));
+}
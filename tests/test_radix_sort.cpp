@@ -0,0 +1,26 @@
+#include "doctest.h"
+#include "radix_sort.h"
+#include "test_random.h"
+#include <vector>
+#include <algorithm>
+
+TEST_CASE("radix_sort_order returns identity for sorted keys") {
+    std::vector<std::uint64_t> keys{1, 1, 5, 9, 1ull << 62};
+    auto order = radix_sort_order(keys);
+    CHECK(order == std::vector<std::size_t>{0, 1, 2, 3, 4});
+    CHECK(radix_sort_order(std::vector<std::uint64_t>{}).empty());
+}
+
+TEST_CASE("radix_sort_order sorts stably") {
+    std::vector<std::uint64_t> keys;
+    test_rng rng(7);
+    for (int i = 0; i < 5000; ++i) keys.push_back((rng.next() >> 20) % (i % 2 ? 4096 : (1ull << 44)));
+    auto order = radix_sort_order(keys);
+    std::vector<std::size_t> expected(keys.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) expected[i] = i;
+    std::ranges::stable_sort(expected, {}, [&](std::size_t i) { return keys[i]; });
+    CHECK(order == expected);
+
+    std::vector<std::uint64_t> small{3, 1, 2, 1};
+    CHECK(radix_sort_order(small) == std::vector<std::size_t>{1, 3, 2, 0});
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "positions.h"
+#include <cstdint>
+#include <vector>
+
+/// @brief Seeded 64-bit linear congruential generator for reproducible test data.
+class test_rng {
+public:
+    /// @brief Start the sequence from seed.
+    explicit test_rng(std::uint64_t seed) : state_(seed) {}
+
+    /// @brief Advance and return the full state; the high bits are the most random.
+    std::uint64_t next() {
+        state_ = state_ * 6364136223846793005ull + 1442695040888963407ull;
+        return state_;
+    }
+
+    /// @brief Pseudo random value below bound, taken from the high bits.
+    std::uint32_t below(std::uint32_t bound) {
+        return static_cast<std::uint32_t>(next() >> 33) % bound;
+    }
+
+private:
+    std::uint64_t state_; ///< Current generator state.
+};
+
+/// @brief Generate n pseudo random positions with coordinates below bound.
+inline std::vector<GlobalPosition> random_positions(std::size_t n, std::uint32_t bound, std::uint64_t seed)
+{
+    std::vector<GlobalPosition> out;
+    out.reserve(n);
+    test_rng rng(seed);
+    for (std::size_t i = 0; i < n; ++i) out.push_back({rng.below(bound), rng.below(bound), rng.below(bound)});
+    return out;
+}
@@ -0,0 +1,47 @@
+#include "doctest.h"
+#include "wide_mask.h"
+#include <vector>
+
+TEST_CASE_TEMPLATE("wide_mask bit operations", Mask, wide_mask<256>, wide_mask<512>) {
+    constexpr std::size_t bits = mask_traits<Mask>::bits;
+    Mask a;
+    CHECK(!a);
+    CHECK(a == 0u);
+    CHECK(mask_countr_zero(a) == int(bits));
+    for (std::size_t bit : {0u, 63u, 64u, 130u, 255u}) a.set(bit);
+    CHECK(a);
+    CHECK(mask_popcount(a) == 5);
+    CHECK(mask_countr_zero(a) == 0);
+    CHECK(mask_test(a, 130));
+    CHECK(!mask_test(a, 131));
+
+    std::vector<std::size_t> seen;
+    for_each_set_bit(a, [&](std::size_t bit) { seen.push_back(bit); });
+    CHECK(seen == std::vector<std::size_t>{0, 63, 64, 130, 255});
+
+    const Mask low = ~Mask{0} << 64;
+    CHECK(mask_countr_zero(a & low) == 64);
+    CHECK(mask_popcount(a & ~low) == 2);
+    CHECK(mask_popcount(~Mask{0}) == int(bits));
+    CHECK(mask_popcount(a ^ a) == 0);
+    CHECK((a | (Mask{1} << 7)) != a);
+    CHECK((Mask{1} << (bits - 1)).word(Mask::words - 1) == std::uint64_t{1} << 63);
+    CHECK((Mask{3} << 63).word(1) == 1u);
+    CHECK(!(Mask{1} << bits));
+
+    Mask b = a;
+    b = mask_clear_lowest(mask_clear_lowest(b));
+    CHECK(mask_countr_zero(b) == 64);
+    CHECK(mask_from_bitset<Mask>(mask_to_bitset(a)) == a);
+    CHECK(mask_to_bitset(a).count() == 5u);
+    CHECK(mask_to_bitset(a).test(130));
+}
+
+TEST_CASE("mask helpers agree for integer masks") {
+    const std::uint64_t m = 0x8000'0000'0000'0101ull;
+    CHECK(mask_popcount(m) == 3);
+    CHECK(mask_countr_zero(m) == 0);
+    CHECK(mask_countr_zero(mask_clear_lowest(m)) == 8);
+    CHECK(mask_from_bitset<std::uint64_t>(mask_to_bitset(m)) == m);
+    CHECK(mask_traits<std::uint32_t>::bits == 32u);
+}